@@ -0,0 +1,376 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "network/TcpServer.h"
+#include "rtsp/RtspClient.h"
+#include "rtsp/H264RtpDecoder.h"
+#include "mux/FlvMuxer.h"
+#include "mux/Fmp4Muxer.h"
+
+class HttpStreamSession;
+
+/**
+ * 一路HTTP直播流（HTTP-FLV / HTTP-fMP4）
+ * 解包和封装在RingBuffer写线程执行，每帧只封装一次
+ * 封装结果投递到poller线程，以同一个Buffer::Ptr发给所有观看者
+ */
+class HttpMediaStream : public std::enable_shared_from_this<HttpMediaStream>,
+                        public RingReader<HttpMediaStream, RtpPacket::Ptr> {
+public:
+    using Ptr = std::shared_ptr<HttpMediaStream>;
+
+    enum Format { FLV = 0, FMP4 = 1, FormatCount };
+
+    // GOP缓存上限（帧数），防止超长GOP占用过多内存
+    static constexpr size_t kMaxGopFrames = 1024;
+
+    HttpMediaStream(const toolkit::EventPoller::Ptr& poller, const RtspClient::Ptr& client)
+        : _poller(poller), _client(client) {}
+
+    ~HttpMediaStream() {
+        if (auto ring = _ring.lock()) {
+            ring->detach(_reader_id);
+        }
+    }
+
+    /**
+     * 挂到RtspClient的RingBuffer上，会先回放GOP缓存
+     * 以裸指针挂载：析构时detach会等待进行中的回调结束，
+     * 且写线程从不持有本对象的强引用，避免在回调内析构导致死锁
+     */
+    void start() {
+        auto client = _client.lock();
+        if (!client) return;
+        _ring = client->getRing();
+        _reader_id = client->getRing()->attach(this);
+    }
+
+    /**
+     * 添加观看者，先发送头部和缓存的GOP（从关键帧开始），必须在poller线程调用
+     */
+    void addViewer(Format format, const std::shared_ptr<HttpStreamSession>& session);
+
+    /**
+     * 观看者数量，必须在poller线程调用
+     */
+    size_t viewerCount(Format format) const { return _tracks[format].viewers.size(); }
+
+private:
+    struct Track {
+        toolkit::Buffer::Ptr header;
+        std::vector<toolkit::Buffer::Ptr> gop;
+        std::vector<std::weak_ptr<HttpStreamSession>> viewers;
+        std::vector<std::weak_ptr<HttpStreamSession>> pending;
+    };
+
+    friend class RingReader<HttpMediaStream, RtpPacket::Ptr>;
+
+    // RingBuffer写线程，由RingReader静态分发逐包调用
+    void onData(const RtpPacket::Ptr& pkt) {
+        if (!_decoder) {
+            _decoder = std::make_shared<H264RtpDecoder>();
+            if (auto client = _client.lock()) {
+                _decoder->setSdp(client->getSdp());
+            }
+            _decoder->setOnFrame([this](const H264Frame::Ptr& frame) { onFrame(frame); });
+        }
+        _decoder->input(pkt);
+    }
+
+    // RingBuffer写线程
+    void onFrame(const H264Frame::Ptr& frame) {
+        std::string cfg = _decoder->getAvcConfig();
+        if (cfg.empty()) return;
+
+        if (cfg != _avc_config) {
+            // SPS/PPS变化，重建头部；已在播放的观看者收到新的AVC sequence header / init segment，
+            // 之后从下一个关键帧继续，否则解码器仍按旧参数解码
+            _avc_config = cfg;
+            auto flv_header = _flv.makeHeader(*_decoder);
+            auto flv_update = _flv.makeConfigTag(*_decoder);
+            auto mp4_header = _mp4.makeInitSegment(*_decoder);
+            std::weak_ptr<HttpMediaStream> weak_self = weak_from_this();
+            _poller->async([weak_self, flv_header, flv_update, mp4_header]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->updateHeader(strong_self->_tracks[FLV], flv_header, flv_update);
+                    strong_self->updateHeader(strong_self->_tracks[FMP4], mp4_header, mp4_header);
+                }
+            }, false);
+            _wait_key = true;
+        }
+
+        if (_wait_key && !frame->key) return;
+        _wait_key = false;
+
+        auto flv = _flv.inputFrame(frame);
+        auto mp4 = _mp4.inputFrame(frame);
+        bool key = frame->key;
+
+        std::weak_ptr<HttpMediaStream> weak_self = weak_from_this();
+        _poller->async([weak_self, flv, mp4, key]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->dispatch(strong_self->_tracks[FLV], flv, key);
+                strong_self->dispatch(strong_self->_tracks[FMP4], mp4, key);
+            }
+        }, false);
+    }
+
+    // poller线程
+    void dispatch(Track& track, const toolkit::Buffer::Ptr& buf, bool key);
+
+    // poller线程，header给之后的新观看者，update发给已在播放的观看者
+    void updateHeader(Track& track, const toolkit::Buffer::Ptr& header, const toolkit::Buffer::Ptr& update);
+
+private:
+    toolkit::EventPoller::Ptr _poller;
+    std::weak_ptr<RtspClient> _client;
+    std::weak_ptr<RtspClient::RingType> _ring;
+    RtspClient::RingType::ReaderId _reader_id = 0;
+
+    // 以下只在RingBuffer写线程访问
+    H264RtpDecoder::Ptr _decoder;
+    FlvMuxer _flv;
+    Fmp4Muxer _mp4;
+    std::string _avc_config;
+    bool _wait_key = true;
+
+    // 以下只在poller线程访问
+    Track _tracks[FormatCount];
+};
+
+class HttpStreamServer;
+
+/**
+ * HTTP观看者会话，只负责请求解析和发送队列管理
+ */
+class HttpStreamSession : public toolkit::TcpSession {
+public:
+    using Ptr = std::shared_ptr<HttpStreamSession>;
+
+    // 发送队列超过该值认为是慢消费者，丢帧直到下一个关键帧
+    static constexpr size_t kMaxSendQueue = 4 * 1024 * 1024;
+
+    HttpStreamSession(const toolkit::EventPoller::Ptr& poller, int fd,
+                      const std::weak_ptr<HttpStreamServer>& server)
+        : TcpSession(poller, fd), _server(server) {}
+
+    /**
+     * 发送一帧（共享Buffer），慢消费者跳过非关键帧
+     */
+    void sendFrame(const toolkit::Buffer::Ptr& buf, bool key) {
+        if (sendQueueBytes() > kMaxSendQueue) {
+            _wait_key = true;
+            return;
+        }
+        if (_wait_key && !key) return;
+        _wait_key = false;
+        send(buf);
+    }
+
+    /**
+     * 发送中途更新的头部（FLV AVC sequence header / fMP4 init segment），
+     * 慢消费者也不能跳过，之后的数据从关键帧开始
+     */
+    void sendHeader(const toolkit::Buffer::Ptr& buf) {
+        send(buf);
+        _wait_key = true;
+    }
+
+protected:
+    void onRecv(const toolkit::Buffer::Ptr& buf) override;
+
+private:
+    void sendStatus(int code, const char* msg) {
+        std::string resp = "HTTP/1.1 " + std::to_string(code) + " " + msg + "\r\n"
+                           "Content-Length: 0\r\n"
+                           "Connection: close\r\n\r\n";
+        send(resp);
+        shutdown(toolkit::SockException(toolkit::Err_other, msg));
+    }
+
+private:
+    std::weak_ptr<HttpStreamServer> _server;
+    std::string _request;
+    bool _playing = false;
+    bool _wait_key = false;
+};
+
+/**
+ * HTTP-FLV / HTTP-fMP4 分发服务器
+ * 访问 http://host:port/<name>.flv 或 http://host:port/<name>.mp4
+ */
+class HttpStreamServer : public std::enable_shared_from_this<HttpStreamServer> {
+public:
+    using Ptr = std::shared_ptr<HttpStreamServer>;
+
+    explicit HttpStreamServer(const toolkit::EventPoller::Ptr& poller = nullptr)
+        : _server(std::make_shared<toolkit::TcpServer>(poller)) {}
+
+    ~HttpStreamServer() {
+        _server->stop();
+    }
+
+    /**
+     * 开始监听
+     * @param port HTTP端口，0表示随机端口
+     */
+    bool start(uint16_t port, const std::string& local_ip = "0.0.0.0") {
+        std::weak_ptr<HttpStreamServer> weak_self = shared_from_this();
+        return _server->start(port, [weak_self](const toolkit::EventPoller::Ptr& poller, int fd) {
+            return std::make_shared<HttpStreamSession>(poller, fd, weak_self);
+        }, local_ip);
+    }
+
+    uint16_t getPort() const { return _server->getPort(); }
+
+    /**
+     * 发布一路拉流
+     * @param name 流名，对应URL路径
+     * @param client 拉流客户端
+     */
+    void addStream(const std::string& name, const RtspClient::Ptr& client) {
+        auto stream = std::make_shared<HttpMediaStream>(_server->getPoller(), client);
+        stream->start();
+        std::weak_ptr<HttpStreamServer> weak_self = shared_from_this();
+        _server->getPoller()->async([weak_self, name, stream]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->_streams[name] = stream;
+            }
+        });
+    }
+
+    void removeStream(const std::string& name) {
+        std::weak_ptr<HttpStreamServer> weak_self = shared_from_this();
+        _server->getPoller()->async([weak_self, name]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->_streams.erase(name);
+            }
+        });
+    }
+
+    /**
+     * 查找流，必须在poller线程调用
+     */
+    HttpMediaStream::Ptr findStream(const std::string& name) const {
+        auto it = _streams.find(name);
+        return it != _streams.end() ? it->second : nullptr;
+    }
+
+private:
+    toolkit::TcpServer::Ptr _server;
+    // 只在poller线程访问
+    std::unordered_map<std::string, HttpMediaStream::Ptr> _streams;
+};
+
+inline void HttpMediaStream::addViewer(Format format, const HttpStreamSession::Ptr& session) {
+    auto& track = _tracks[format];
+    if (!track.header || track.gop.empty()) {
+        // 还没有关键帧，等下一个关键帧再开始发送
+        track.pending.emplace_back(session);
+        return;
+    }
+    session->send(track.header);
+    for (auto& buf : track.gop) {
+        session->send(buf);
+    }
+    track.viewers.emplace_back(session);
+}
+
+inline void HttpMediaStream::updateHeader(Track& track, const toolkit::Buffer::Ptr& header,
+                                          const toolkit::Buffer::Ptr& update) {
+    track.header = header;
+    // 缓存的GOP属于旧参数，新观看者等下一个关键帧
+    track.gop.clear();
+    if (!update) return;
+    for (auto& weak_viewer : track.viewers) {
+        auto viewer = weak_viewer.lock();
+        if (viewer && viewer->alive()) viewer->sendHeader(update);
+    }
+}
+
+inline void HttpMediaStream::dispatch(Track& track, const toolkit::Buffer::Ptr& buf, bool key) {
+    if (key) {
+        track.gop.clear();
+        for (auto& weak_viewer : track.pending) {
+            auto viewer = weak_viewer.lock();
+            if (viewer && viewer->alive() && track.header) {
+                viewer->send(track.header);
+                track.viewers.emplace_back(viewer);
+            }
+        }
+        track.pending.clear();
+    }
+    if (track.gop.size() < kMaxGopFrames) {
+        track.gop.push_back(buf);
+    }
+
+    for (size_t i = 0; i < track.viewers.size();) {
+        auto viewer = track.viewers[i].lock();
+        if (!viewer || !viewer->alive()) {
+            track.viewers[i] = std::move(track.viewers.back());
+            track.viewers.pop_back();
+            continue;
+        }
+        viewer->sendFrame(buf, key);
+        ++i;
+    }
+}
+
+inline void HttpStreamSession::onRecv(const toolkit::Buffer::Ptr& buf) {
+    if (_playing) return;  // 播放中忽略客户端数据
+
+    _request.append(buf->data(), buf->size());
+    size_t header_end = _request.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        if (_request.size() > 8 * 1024) sendStatus(400, "Bad Request");
+        return;
+    }
+
+    char method[16] = {0}, path[1024] = {0};
+    if (sscanf(_request.c_str(), "%15s %1023s", method, path) != 2 || strcmp(method, "GET") != 0) {
+        sendStatus(405, "Method Not Allowed");
+        return;
+    }
+
+    // /<name>.flv?query -> name + 扩展名
+    std::string url = path;
+    url = url.substr(0, url.find('?'));
+    size_t dot = url.rfind('.');
+    if (url.empty() || url[0] != '/' || dot == std::string::npos) {
+        sendStatus(404, "Not Found");
+        return;
+    }
+    std::string name = url.substr(1, dot - 1);
+    std::string ext = url.substr(dot + 1);
+
+    HttpMediaStream::Format format;
+    const char* content_type;
+    if (ext == "flv") {
+        format = HttpMediaStream::FLV;
+        content_type = "video/x-flv";
+    } else if (ext == "mp4") {
+        format = HttpMediaStream::FMP4;
+        content_type = "video/mp4";
+    } else {
+        sendStatus(404, "Not Found");
+        return;
+    }
+
+    auto server = _server.lock();
+    auto stream = server ? server->findStream(name) : nullptr;
+    if (!stream) {
+        sendStatus(404, "Not Found");
+        return;
+    }
+
+    _playing = true;
+    _request.clear();
+    send(std::string("HTTP/1.1 200 OK\r\n") +
+         "Content-Type: " + content_type + "\r\n"
+         "Cache-Control: no-cache\r\n"
+         "Access-Control-Allow-Origin: *\r\n"
+         "Connection: close\r\n\r\n");
+    stream->addViewer(format, std::static_pointer_cast<HttpStreamSession>(shared_from_this()));
+}
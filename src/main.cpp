@@ -1,17 +1,26 @@
-#include "rtsp/RtspClient.h"
+#include "rtsp/StreamManager.h"
+#include "http/HttpStreamServer.h"
+#include "rtsp/RtspServer.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <rtsp://url>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <rtsp://url> [http_port] [rtsp_port]" << std::endl;
         return 1;
     }
 
-    auto client = std::make_shared<RtspClient>();
+    // 管理器负责排队启动、失败退避和重连
+    auto manager = std::make_shared<StreamManager>();
+    manager->setOnPlayResult([](const std::string& /*url*/, bool success, const std::string& msg) {
+        std::cout << "Play result: " << (success ? "Success" : "Failed")
+                  << " - " << msg << std::endl;
+    });
+    auto client = manager->play(argv[1]);
 
-    client->getRing()->setOnData([](const RtpPacket::Ptr& pkt) {
+    // 打印在线程池中异步执行，不占用收包线程
+    client->getRing()->attachAsync([](const RtpPacket::Ptr& pkt) {
         std::cout << "RTP: seq=" << pkt->seq
                   << " ts=" << pkt->timestamp
                   << " pt=" << (int)pkt->pt
@@ -20,12 +29,25 @@ int main(int argc, char* argv[]) {
                   << std::endl;
     });
 
-    client->setOnPlayResult([](bool success, const std::string& msg) {
-        std::cout << "Play result: " << (success ? "Success" : "Failed")
-                  << " - " << msg << std::endl;
-    });
+    // 可选：HTTP-FLV/fMP4分发，访问 http://127.0.0.1:<port>/live.flv 或 /live.mp4
+    HttpStreamServer::Ptr http_server;
+    if (argc >= 3 && std::stoi(argv[2]) > 0) {
+        http_server = std::make_shared<HttpStreamServer>();
+        if (http_server->start((uint16_t)std::stoi(argv[2]))) {
+            http_server->addStream("live", client);
+            std::cout << "HTTP server listening on port " << http_server->getPort() << std::endl;
+        }
+    }
 
-    client->play(argv[1]);
+    // 可选：RTSP转发，访问 rtsp://127.0.0.1:<port>/live
+    RtspServer::Ptr rtsp_server;
+    if (argc >= 4) {
+        rtsp_server = std::make_shared<RtspServer>();
+        if (rtsp_server->start((uint16_t)std::stoi(argv[3]))) {
+            rtsp_server->addStream("live", client);
+            std::cout << "RTSP server listening on port " << rtsp_server->getPort() << std::endl;
+        }
+    }
 
     // 运行30秒
     std::this_thread::sleep_for(std::chrono::seconds(30));
@@ -0,0 +1,119 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "rtsp/H264RtpDecoder.h"
+#include "util/Buffer.h"
+
+/**
+ * FLV封装（仅视频，H264）
+ * 每帧只封装一次，输出的Buffer可以被所有观看者共享
+ */
+class FlvMuxer {
+public:
+    /**
+     * FLV文件头 + AVC sequence header，新观看者需要先收到它
+     * @return SPS/PPS未就绪时返回nullptr
+     */
+    toolkit::Buffer::Ptr makeHeader(const H264RtpDecoder& decoder) {
+        std::string cfg = decoder.getAvcConfig();
+        if (cfg.empty()) return nullptr;
+
+        std::string out;
+        // FLV header: "FLV" version=1 flags=video offset=9, PreviousTagSize0
+        static const char header[] = {'F', 'L', 'V', 0x01, 0x01, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00};
+        out.append(header, sizeof(header));
+        appendTag(out, 9, 0, sequenceHeader(cfg));
+        return std::make_shared<toolkit::BufferString>(std::move(out));
+    }
+
+    /**
+     * 流中途SPS/PPS变化时发给已在播放的观看者的AVC sequence header tag，
+     * 时间戳取上一帧，不晚于之后的关键帧
+     * @return SPS/PPS未就绪时返回nullptr
+     */
+    toolkit::Buffer::Ptr makeConfigTag(const H264RtpDecoder& decoder) {
+        std::string cfg = decoder.getAvcConfig();
+        if (cfg.empty()) return nullptr;
+
+        std::string out;
+        appendTag(out, 9, _elapsed > 0 ? (uint32_t)(_elapsed / 90) : 0, sequenceHeader(cfg));
+        return std::make_shared<toolkit::BufferString>(std::move(out));
+    }
+
+    /**
+     * 封装一帧为FLV video tag
+     */
+    toolkit::Buffer::Ptr inputFrame(const H264Frame::Ptr& frame) {
+        uint32_t dts = stampMs(frame->timestamp);
+
+        auto buf = std::make_shared<toolkit::BufferRaw>(11 + 5 + frame->data.size() + 4);
+        char* p = buf->data();
+        size_t body_len = 5 + frame->data.size();
+        writeTagHeader(p, 9, body_len, dts);
+        p += 11;
+        *p++ = frame->key ? 0x17 : 0x27;
+        *p++ = 0x01;  // AVC NALU
+        *p++ = 0; *p++ = 0; *p++ = 0;
+        memcpy(p, frame->data.data(), frame->data.size());
+        p += frame->data.size();
+        writeUint32(p, (uint32_t)(11 + body_len));
+        buf->setSize(11 + body_len + 4);
+        return buf;
+    }
+
+private:
+    static std::string sequenceHeader(const std::string& cfg) {
+        std::string body;
+        body.push_back(0x17);  // keyframe + AVC
+        body.push_back(0x00);  // AVC sequence header
+        body.append(3, '\0');  // composition time
+        body.append(cfg);
+        return body;
+    }
+
+    uint32_t stampMs(uint32_t rtp_ts) {
+        if (!_have_base) {
+            _have_base = true;
+            _last_rtp = rtp_ts;
+        }
+        // 32位RTP时间戳回绕按有符号差值累加
+        _elapsed += (int32_t)(rtp_ts - _last_rtp);
+        _last_rtp = rtp_ts;
+        return _elapsed > 0 ? (uint32_t)(_elapsed / 90) : 0;
+    }
+
+    static void writeUint32(char* p, uint32_t v) {
+        p[0] = (char)(v >> 24);
+        p[1] = (char)(v >> 16);
+        p[2] = (char)(v >> 8);
+        p[3] = (char)v;
+    }
+
+    static void writeTagHeader(char* p, uint8_t type, size_t body_len, uint32_t ts) {
+        p[0] = (char)type;
+        p[1] = (char)(body_len >> 16);
+        p[2] = (char)(body_len >> 8);
+        p[3] = (char)body_len;
+        p[4] = (char)(ts >> 16);
+        p[5] = (char)(ts >> 8);
+        p[6] = (char)ts;
+        p[7] = (char)(ts >> 24);  // timestamp extended
+        p[8] = p[9] = p[10] = 0;  // stream id
+    }
+
+    static void appendTag(std::string& out, uint8_t type, uint32_t ts, const std::string& body) {
+        char hdr[11];
+        writeTagHeader(hdr, type, body.size(), ts);
+        out.append(hdr, 11);
+        out.append(body);
+        char prev[4];
+        writeUint32(prev, (uint32_t)(11 + body.size()));
+        out.append(prev, 4);
+    }
+
+private:
+    bool _have_base = false;
+    uint32_t _last_rtp = 0;
+    int64_t _elapsed = 0;
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "rtsp/H264RtpDecoder.h"
+#include "util/Buffer.h"
+
+/**
+ * fMP4封装（仅视频，H264，ISO/IEC 14496-12）
+ * 每帧一个moof+mdat分片，延迟最低；输出Buffer可被所有观看者共享
+ */
+class Fmp4Muxer {
+public:
+    static constexpr uint32_t kTimeScale = 90000;
+
+    /**
+     * 初始化分片ftyp+moov，新观看者需要先收到它
+     * @return SPS/PPS未就绪时返回nullptr
+     */
+    toolkit::Buffer::Ptr makeInitSegment(const H264RtpDecoder& decoder) {
+        std::string cfg = decoder.getAvcConfig();
+        if (cfg.empty()) return nullptr;
+
+        int width = 0, height = 0;
+        decoder.getResolution(width, height);
+
+        BoxWriter w;
+        w.begin("ftyp");
+        w.fourcc("isom"); w.u32(0x200);
+        w.fourcc("isom"); w.fourcc("iso6"); w.fourcc("avc1"); w.fourcc("mp41");
+        w.end();
+
+        w.begin("moov");
+        {
+            w.beginFull("mvhd", 0, 0);
+            w.u32(0); w.u32(0);              // creation/modification time
+            w.u32(1000); w.u32(0);           // timescale, duration
+            w.u32(0x00010000); w.u16(0x0100);  // rate, volume
+            w.zero(10);
+            writeMatrix(w);
+            w.zero(24);                      // pre_defined
+            w.u32(2);                        // next_track_ID
+            w.end();
+
+            w.begin("trak");
+            {
+                w.beginFull("tkhd", 0, 0x03);
+                w.u32(0); w.u32(0);          // creation/modification time
+                w.u32(1); w.u32(0);          // track_ID, reserved
+                w.u32(0);                    // duration
+                w.zero(8);
+                w.u16(0); w.u16(0); w.u16(0); w.u16(0);  // layer, alternate_group, volume, reserved
+                writeMatrix(w);
+                w.u32((uint32_t)width << 16); w.u32((uint32_t)height << 16);
+                w.end();
+
+                w.begin("mdia");
+                {
+                    w.beginFull("mdhd", 0, 0);
+                    w.u32(0); w.u32(0);
+                    w.u32(kTimeScale); w.u32(0);
+                    w.u16(0x55C4); w.u16(0);  // language "und"
+                    w.end();
+
+                    w.beginFull("hdlr", 0, 0);
+                    w.u32(0); w.fourcc("vide"); w.zero(12);
+                    w.raw("VideoHandler", 13);
+                    w.end();
+
+                    w.begin("minf");
+                    {
+                        w.beginFull("vmhd", 0, 1);
+                        w.zero(8);
+                        w.end();
+
+                        w.begin("dinf");
+                        w.beginFull("dref", 0, 0);
+                        w.u32(1);
+                        w.beginFull("url ", 0, 1);
+                        w.end();
+                        w.end();
+                        w.end();
+
+                        w.begin("stbl");
+                        {
+                            w.beginFull("stsd", 0, 0);
+                            w.u32(1);
+                            w.begin("avc1");
+                            w.zero(6); w.u16(1);          // reserved, data_reference_index
+                            w.zero(16);                   // pre_defined, reserved
+                            w.u16((uint16_t)width); w.u16((uint16_t)height);
+                            w.u32(0x00480000); w.u32(0x00480000);  // 72dpi
+                            w.u32(0); w.u16(1);           // reserved, frame_count
+                            w.zero(32);                   // compressorname
+                            w.u16(0x0018); w.u16(0xFFFF); // depth, pre_defined
+                            w.begin("avcC");
+                            w.raw(cfg.data(), cfg.size());
+                            w.end();
+                            w.end();
+                            w.end();
+
+                            // 分片MP4的样本表为空
+                            w.beginFull("stts", 0, 0); w.u32(0); w.end();
+                            w.beginFull("stsc", 0, 0); w.u32(0); w.end();
+                            w.beginFull("stsz", 0, 0); w.u32(0); w.u32(0); w.end();
+                            w.beginFull("stco", 0, 0); w.u32(0); w.end();
+                        }
+                        w.end();
+                    }
+                    w.end();
+                }
+                w.end();
+            }
+            w.end();
+
+            w.begin("mvex");
+            w.beginFull("trex", 0, 0);
+            w.u32(1); w.u32(1); w.u32(0); w.u32(0); w.u32(0);
+            w.end();
+            w.end();
+        }
+        w.end();
+
+        return std::make_shared<toolkit::BufferString>(w.take());
+    }
+
+    /**
+     * 封装一帧为moof+mdat
+     */
+    toolkit::Buffer::Ptr inputFrame(const H264Frame::Ptr& frame) {
+        uint64_t decode_time = stamp(frame->timestamp);
+
+        BoxWriter w;
+        w.begin("moof");
+        {
+            w.beginFull("mfhd", 0, 0);
+            w.u32(++_sequence);
+            w.end();
+
+            w.begin("traf");
+            {
+                w.beginFull("tfhd", 0, 0x020000);  // default-base-is-moof
+                w.u32(1);
+                w.end();
+
+                w.beginFull("tfdt", 1, 0);
+                w.u64(decode_time);
+                w.end();
+
+                // data-offset | sample-duration | sample-size | sample-flags
+                w.beginFull("trun", 0, 0x000701);
+                w.u32(1);
+                size_t data_offset_pos = w.size();
+                w.u32(0);
+                w.u32(_duration);
+                w.u32((uint32_t)frame->data.size());
+                w.u32(frame->key ? 0x02000000 : 0x01010000);
+                w.end();
+                w.end();
+                w.end();
+
+                // 只有一个样本，数据紧跟在moof之后的mdat头后面
+                w.patch32(data_offset_pos, (uint32_t)(w.size() + 8));
+            }
+        }
+
+        std::string out = w.take();
+        uint32_t mdat_size = (uint32_t)(8 + frame->data.size());
+        auto buf = std::make_shared<toolkit::BufferRaw>(out.size() + mdat_size);
+        char* p = buf->data();
+        memcpy(p, out.data(), out.size());
+        p += out.size();
+        p[0] = (char)(mdat_size >> 24);
+        p[1] = (char)(mdat_size >> 16);
+        p[2] = (char)(mdat_size >> 8);
+        p[3] = (char)mdat_size;
+        memcpy(p + 4, "mdat", 4);
+        memcpy(p + 8, frame->data.data(), frame->data.size());
+        buf->setSize(out.size() + mdat_size);
+        return buf;
+    }
+
+private:
+    /**
+     * 简单的box写入器，begin/end自动回填长度
+     */
+    class BoxWriter {
+    public:
+        void begin(const char* type) {
+            _stack.push_back(_buf.size());
+            u32(0);
+            fourcc(type);
+        }
+        void beginFull(const char* type, uint8_t version, uint32_t flags) {
+            begin(type);
+            u32(((uint32_t)version << 24) | (flags & 0xFFFFFF));
+        }
+        void end() {
+            size_t start = _stack.back();
+            _stack.pop_back();
+            patch32(start, (uint32_t)(_buf.size() - start));
+        }
+        void u16(uint16_t v) {
+            _buf.push_back((char)(v >> 8));
+            _buf.push_back((char)v);
+        }
+        void u32(uint32_t v) {
+            u16((uint16_t)(v >> 16));
+            u16((uint16_t)v);
+        }
+        void u64(uint64_t v) {
+            u32((uint32_t)(v >> 32));
+            u32((uint32_t)v);
+        }
+        void fourcc(const char* s) { _buf.append(s, 4); }
+        void zero(size_t n) { _buf.append(n, '\0'); }
+        void raw(const char* data, size_t len) { _buf.append(data, len); }
+        void patch32(size_t pos, uint32_t v) {
+            _buf[pos] = (char)(v >> 24);
+            _buf[pos + 1] = (char)(v >> 16);
+            _buf[pos + 2] = (char)(v >> 8);
+            _buf[pos + 3] = (char)v;
+        }
+        size_t size() const { return _buf.size(); }
+        std::string take() { return std::move(_buf); }
+
+    private:
+        std::string _buf;
+        std::vector<size_t> _stack;
+    };
+
+    static void writeMatrix(BoxWriter& w) {
+        static const uint32_t matrix[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+        for (uint32_t v : matrix) w.u32(v);
+    }
+
+    uint64_t stamp(uint32_t rtp_ts) {
+        if (!_have_base) {
+            _have_base = true;
+            _last_rtp = rtp_ts;
+        }
+        int32_t delta = (int32_t)(rtp_ts - _last_rtp);
+        if (delta > 0) {
+            // 下一帧时长未知，用上一帧间隔近似
+            _duration = (uint32_t)delta;
+            _elapsed += delta;
+        }
+        _last_rtp = rtp_ts;
+        return _elapsed;
+    }
+
+private:
+    bool _have_base = false;
+    uint32_t _last_rtp = 0;
+    uint64_t _elapsed = 0;
+    uint32_t _duration = 3600;  // 默认25fps
+    uint32_t _sequence = 0;
+};
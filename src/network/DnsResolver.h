@@ -0,0 +1,124 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include "util/SockUtil.h"
+
+namespace toolkit {
+
+/**
+ * 异步DNS解析，getaddrinfo在专用线程上阻塞，不占用I/O loop
+ * 1. 同一域名同时只解析一次，期间的请求挂在同一个解析上（大量连接同时重连时不会放大DNS请求）
+ * 2. 成功和失败结果都由SockUtil缓存，解析器宕机期间重连直接失败，不再排队等待
+ * 回调在解析线程执行，使用者需自行投递回自己的loop
+ */
+class DnsResolver {
+public:
+    using OnResolved = std::function<void(bool ok, const sockaddr_storage& addr)>;
+
+    struct Config {
+        // 解析线程数，一个慢域名最多占住一个线程
+        size_t threads = 2;
+        // 成功/失败结果缓存时间（秒）
+        int cache_sec = 60;
+        int fail_cache_sec = 5;
+    };
+
+    /**
+     * 设置配置，必须在第一次调用Instance()之前设置
+     */
+    static void setConfig(const Config& config) { configRef() = config; }
+
+    static DnsResolver& Instance() {
+        // 不析构：退出时解析线程可能仍阻塞在getaddrinfo里
+        static DnsResolver* instance = new DnsResolver(configRef());
+        return *instance;
+    }
+
+    const Config& getConfig() const { return _config; }
+
+    /**
+     * 只查IP字面量和缓存，不阻塞
+     * @param failed 命中失败缓存时为true
+     * @return 是否得到结果（成功或近期已失败）
+     */
+    bool lookup(const std::string& host, uint16_t port, sockaddr_storage& addr, bool& failed) const {
+        return SockUtil::getDomainIPCached(host.c_str(), port, addr, failed, _config.cache_sec, _config.fail_cache_sec);
+    }
+
+    /**
+     * 在解析线程上解析，完成后在解析线程回调，可在任意线程调用
+     */
+    void resolve(const std::string& host, uint16_t port, OnResolved cb) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& waiters = _pending[host];
+        waiters.push_back(Waiter{port, std::move(cb)});
+        if (waiters.size() == 1) {
+            _queue.push_back(host);
+            _cond.notify_one();
+        }
+    }
+
+private:
+    struct Waiter {
+        uint16_t port;
+        OnResolved cb;
+    };
+
+    explicit DnsResolver(const Config& config) : _config(config) {
+        size_t threads = config.threads ? config.threads : 1;
+        for (size_t i = 0; i < threads; ++i) {
+            std::thread([this]() { run(); }).detach();
+        }
+    }
+
+    static Config& configRef() {
+        static Config config;
+        return config;
+    }
+
+    void run() {
+        pthread_setname_np(pthread_self(), "dns resolver");
+        for (;;) {
+            std::string host;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() { return !_queue.empty(); });
+                host = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            sockaddr_storage addr;
+            bool ok = SockUtil::getDomainIP(host.c_str(), 0, addr, _config.cache_sec, _config.fail_cache_sec);
+
+            std::vector<Waiter> waiters;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _pending.find(host);
+                if (it != _pending.end()) {
+                    waiters.swap(it->second);
+                    _pending.erase(it);
+                }
+            }
+            for (auto& waiter : waiters) {
+                sockaddr_storage out = addr;
+                if (ok) SockUtil::setPort(out, waiter.port);
+                waiter.cb(ok, out);
+            }
+        }
+    }
+
+private:
+    Config _config;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<std::string> _queue;
+    std::unordered_map<std::string, std::vector<Waiter>> _pending;
+};
+
+} // namespace toolkit
@@ -0,0 +1,303 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "util/Buffer.h"
+#include "util/ThreadPlacement.h"
+#include "util/TimerWheel.h"
+
+namespace toolkit {
+
+/**
+ * 事件循环（参考ZLToolKit的EventPoller）
+ * 一个线程 + 一个epoll，负责fd事件分发和跨线程任务投递
+ * fd回调只在本线程执行，因此回调内可以无锁访问会话状态
+ */
+class EventPoller : public std::enable_shared_from_this<EventPoller> {
+public:
+    using Ptr = std::shared_ptr<EventPoller>;
+    using PollEventCB = std::function<void(int event)>;
+    using Task = std::function<void()>;
+    using DelayTask = TimerWheel::Timer;
+
+    enum Event {
+        Event_Read  = 1 << 0,
+        Event_Write = 1 << 1,
+        Event_Error = 1 << 2
+    };
+
+    /**
+     * 创建并启动事件循环
+     * @param name 线程名
+     * @param cpus 绑定的CPU集合，空表示不绑核
+     * @param numa_local 是否把本线程的内存分配（接收缓冲等）放在本地NUMA节点
+     * @param spin 忙轮询模式，epoll_wait不阻塞，独占一个CPU换取更低的唤醒延时
+     */
+    static Ptr create(const std::string& name = "poller", const CpuSet& cpus = CpuSet(), bool numa_local = false,
+                      bool spin = false) {
+        auto poller = Ptr(new EventPoller(name));
+        poller->_cpus = cpus;
+        poller->_numa_local = numa_local;
+        poller->_spin = spin;
+        poller->start();
+        return poller;
+    }
+
+    ~EventPoller() {
+        shutdown();
+        if (_event_fd >= 0) ::close(_event_fd);
+        if (_epoll_fd >= 0) ::close(_epoll_fd);
+    }
+
+    /**
+     * 监听fd事件，非本线程调用时会切换到本线程执行
+     * @param fd 文件描述符
+     * @param event Event_Read/Event_Write/Event_Error组合
+     * @param cb 事件回调
+     */
+    void addEvent(int fd, int event, PollEventCB cb) {
+        if (!isCurrentThread()) {
+            // 先计入负载，连续选择loop时（如一次accept多个连接）不会都落在同一个loop上
+            ++_fd_count;
+            async([this, fd, event, cb]() { addEvent(fd, event, cb); });
+            return;
+        }
+        struct epoll_event ev{};
+        ev.events = toEpoll(event);
+        ev.data.fd = fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+            _event_map[fd] = std::make_shared<PollEventCB>(std::move(cb));
+            _fd_count = _event_map.size();
+        }
+    }
+
+    /**
+     * 取消监听fd，非本线程调用时会切换到本线程执行
+     */
+    void delEvent(int fd) {
+        if (!isCurrentThread()) {
+            async([this, fd]() { delEvent(fd); });
+            return;
+        }
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        _event_map.erase(fd);
+        _fd_count = _event_map.size();
+    }
+
+    /**
+     * 修改监听的事件类型，必须在本线程调用
+     */
+    void modifyEvent(int fd, int event) {
+        struct epoll_event ev{};
+        ev.events = toEpoll(event);
+        ev.data.fd = fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    /**
+     * 投递任务到本线程执行
+     * @param may_sync 当前已在本线程时是否直接执行
+     */
+    void async(Task task, bool may_sync = true) {
+        if (may_sync && isCurrentThread()) {
+            task();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_task_mutex);
+            _tasks.emplace_back(std::move(task));
+        }
+        uint64_t one = 1;
+        ssize_t n = ::write(_event_fd, &one, sizeof(one));
+        (void)n;
+    }
+
+    /**
+     * 在本线程执行任务并等待完成
+     */
+    void sync(const Task& task) {
+        if (isCurrentThread() || !_running) {
+            task();
+            return;
+        }
+        std::promise<void> done;
+        auto fut = done.get_future();
+        async([&]() {
+            task();
+            done.set_value();
+        }, false);
+        fut.wait();
+    }
+
+    /**
+     * 延时任务，由本线程的时间轮驱动，不产生额外系统调用
+     * @param delay_ms 延时（毫秒）
+     * @param task 返回下次执行的延时(ms)，返回0表示只执行一次
+     * @return 任务句柄，可在任意线程cancel()
+     */
+    DelayTask::Ptr doDelayTask(uint64_t delay_ms, TimerWheel::Task task) {
+        auto timer = std::make_shared<DelayTask>(std::move(task));
+        async([this, timer, delay_ms]() { _timer_wheel.add(timer, delay_ms); });
+        return timer;
+    }
+
+    /**
+     * 单调时钟（毫秒）
+     */
+    static uint64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool isCurrentThread() const {
+        return _loop_thread_id == std::this_thread::get_id();
+    }
+
+    /**
+     * 本线程共享的接收缓冲，onRecv是同步回调，同一线程的所有socket可以复用
+     */
+    const BufferRaw::Ptr& getSharedBuffer() const { return _shared_buffer; }
+
+    const std::string& getName() const { return _name; }
+
+    const CpuSet& getCpus() const { return _cpus; }
+    bool isSpinning() const { return _spin; }
+
+    /**
+     * 本线程的NUMA节点，未设置NUMA策略时为-1
+     */
+    int getNumaNode() const { return _numa_node; }
+
+    /**
+     * 监听的fd数量，用于负载均衡
+     */
+    size_t getLoad() const { return _fd_count; }
+
+    void shutdown() {
+        if (!_running.exchange(false)) return;
+        uint64_t one = 1;
+        ssize_t n = ::write(_event_fd, &one, sizeof(one));
+        (void)n;
+        if (_loop_thread.joinable()) {
+            if (isCurrentThread()) {
+                _loop_thread.detach();
+            } else {
+                _loop_thread.join();
+            }
+        }
+    }
+
+private:
+    explicit EventPoller(const std::string& name) : _name(name), _timer_wheel(10, nowMs()) {
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        struct epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = _event_fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &ev);
+    }
+
+    void start() {
+        _running = true;
+        std::promise<void> ready;
+        auto fut = ready.get_future();
+        _loop_thread = std::thread([this, &ready]() {
+            // 先绑核和设置NUMA策略，再在本线程分配接收缓冲，使其落在本地节点
+            pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+            _numa_node = ThreadPlacement::apply(_cpus, _numa_local);
+            _shared_buffer = std::make_shared<BufferRaw>(64 * 1024);  // 64KB接收缓冲
+            ready.set_value();
+            runLoop();
+        });
+        _loop_thread_id = _loop_thread.get_id();
+        fut.wait();
+    }
+
+    static uint32_t toEpoll(int event) {
+        uint32_t ret = 0;
+        if (event & Event_Read)  ret |= EPOLLIN;
+        if (event & Event_Write) ret |= EPOLLOUT;
+        if (event & Event_Error) ret |= EPOLLERR | EPOLLHUP;
+        return ret;
+    }
+
+    static int fromEpoll(uint32_t events) {
+        int ret = 0;
+        if (events & EPOLLIN)  ret |= Event_Read;
+        if (events & EPOLLOUT) ret |= Event_Write;
+        if (events & (EPOLLERR | EPOLLHUP)) ret |= Event_Error;
+        return ret;
+    }
+
+    void onWakeup() {
+        uint64_t val;
+        ssize_t n = ::read(_event_fd, &val, sizeof(val));
+        (void)n;
+
+        std::vector<Task> tasks;
+        {
+            std::lock_guard<std::mutex> lock(_task_mutex);
+            tasks.swap(_tasks);
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+    void runLoop() {
+        struct epoll_event events[256];
+        while (_running) {
+            uint64_t now = nowMs();
+            _timer_wheel.advance(now);
+            int n = epoll_wait(_epoll_fd, events, 256, _spin ? 0 : _timer_wheel.nextTimeout(now));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == _event_fd) {
+                    onWakeup();
+                    continue;
+                }
+                auto it = _event_map.find(fd);
+                if (it == _event_map.end()) continue;
+                // 持有回调副本，防止回调内delEvent导致自身被析构
+                auto cb = it->second;
+                (*cb)(fromEpoll(events[i].events));
+            }
+        }
+    }
+
+private:
+    std::string _name;
+    int _epoll_fd = -1;
+    int _event_fd = -1;
+    std::atomic<bool> _running{false};
+    std::thread _loop_thread;
+    std::thread::id _loop_thread_id;
+    CpuSet _cpus;
+    bool _numa_local = false;
+    bool _spin = false;
+    int _numa_node = -1;
+    std::atomic<size_t> _fd_count{0};
+
+    std::mutex _task_mutex;
+    std::vector<Task> _tasks;
+    std::unordered_map<int, std::shared_ptr<PollEventCB>> _event_map;
+    BufferRaw::Ptr _shared_buffer;
+    TimerWheel _timer_wheel;
+};
+
+} // namespace toolkit
@@ -0,0 +1,132 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include "network/EventPoller.h"
+#include "util/ThreadPlacement.h"
+#include "util/SockUtil.h"
+
+namespace toolkit {
+
+/**
+ * EventPoller线程池（参考ZLToolKit的EventPollerPool）
+ * 所有网络I/O运行在固定数量的loop上，支持绑核、NUMA本地内存和按网卡队列选择loop
+ */
+class EventPollerPool {
+public:
+    struct Config {
+        // loop数量，0表示CPU核数（配置了cpus时取cpus.size()）
+        size_t size = 0;
+        // 每个loop绑定的CPU集合，按下标分配，不足时循环使用；空表示不绑核
+        std::vector<CpuSet> cpus;
+        // loop线程的内存分配（接收缓冲、RtpPacket、GOP缓存）优先落在本地NUMA节点
+        bool numa_local = false;
+        // 按SO_INCOMING_CPU把会话分配到处理该网卡队列的CPU对应的loop
+        bool steer_by_incoming_cpu = false;
+        // 低延时连接专用的忙轮询loop绑定的CPU，该loop在第一次使用时创建并独占一个核
+        CpuSet low_latency_cpus;
+    };
+
+    /**
+     * 设置线程池配置，必须在第一次调用Instance()之前设置
+     */
+    static void setConfig(const Config& config) {
+        configRef() = config;
+    }
+
+    static EventPollerPool& Instance() {
+        static EventPollerPool instance(configRef());
+        return instance;
+    }
+
+    /**
+     * 获取负载最小的loop
+     * @param prefer_current 当前线程就是某个loop时优先返回它，避免跨线程
+     */
+    EventPoller::Ptr getPoller(bool prefer_current = true) const {
+        if (prefer_current) {
+            for (auto& poller : _pollers) {
+                if (poller->isCurrentThread()) return poller;
+            }
+        }
+        EventPoller::Ptr best;
+        for (auto& poller : _pollers) {
+            if (!best || poller->getLoad() < best->getLoad()) best = poller;
+        }
+        return best;
+    }
+
+    /**
+     * 获取绑定了指定CPU的loop，没有则返回负载最小的loop
+     */
+    EventPoller::Ptr getPollerForCpu(int cpu) const {
+        EventPoller::Ptr best;
+        for (auto& poller : _pollers) {
+            if (!poller->getCpus().contains(cpu)) continue;
+            if (!best || poller->getLoad() < best->getLoad()) best = poller;
+        }
+        return best ? best : getPoller(false);
+    }
+
+    /**
+     * 为已连接的socket选择loop：开启steer_by_incoming_cpu时按SO_INCOMING_CPU选择
+     * @param prefer_current 见getPoller，服务器分配accept到的连接时应传false
+     */
+    EventPoller::Ptr getPollerForSock(int fd, bool prefer_current = true) const {
+        if (_config.steer_by_incoming_cpu && fd >= 0) {
+            int cpu = SockUtil::getIncomingCpu(fd);
+            if (cpu >= 0) return getPollerForCpu(cpu);
+        }
+        return getPoller(prefer_current);
+    }
+
+    /**
+     * 低延时连接专用的忙轮询loop，不参与getPoller的负载均衡
+     */
+    EventPoller::Ptr getLowLatencyPoller() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_low_latency_poller) {
+            _low_latency_poller = EventPoller::create("poller-spin", _config.low_latency_cpus, _config.numa_local, true);
+        }
+        return _low_latency_poller;
+    }
+
+    size_t size() const { return _pollers.size(); }
+    const Config& getConfig() const { return _config; }
+
+    ~EventPollerPool() {
+        for (auto& poller : _pollers) {
+            poller->shutdown();
+        }
+        if (_low_latency_poller) _low_latency_poller->shutdown();
+    }
+
+private:
+    explicit EventPollerPool(const Config& config) : _config(config) {
+        size_t size = config.size;
+        if (size == 0) {
+            size = !config.cpus.empty() ? config.cpus.size() : std::thread::hardware_concurrency();
+        }
+        if (size == 0) size = 1;
+
+        for (size_t i = 0; i < size; ++i) {
+            CpuSet cpus = config.cpus.empty() ? CpuSet() : config.cpus[i % config.cpus.size()];
+            _pollers.push_back(EventPoller::create("poller-" + std::to_string(i), cpus, config.numa_local));
+        }
+    }
+
+    static Config& configRef() {
+        static Config config;
+        return config;
+    }
+
+private:
+    Config _config;
+    std::vector<EventPoller::Ptr> _pollers;
+    std::mutex _mutex;
+    EventPoller::Ptr _low_latency_poller;
+};
+
+} // namespace toolkit
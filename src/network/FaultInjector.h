@@ -0,0 +1,127 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace toolkit {
+
+/**
+ * TcpClient收包故障注入，用于浸泡测试；不设置时收包路径只多一次空指针判断
+ * 1. 分片：一次读到的数据拆成多段分别回调onRecv，段长在[chunk_min, chunk_max]内随机，
+ *    chunk_max=1时每个字节单独回调，可以拆开interleaved的$头和RTSP头部
+ * 2. 停顿：按概率暂停读取一段时间，数据堆积在内核缓冲，模拟网络卡顿和慢速对端
+ * 3. 复位：按概率以RST断开连接，走正常的onError/重连流程
+ * 4. 丢失：按概率丢弃一段字节，模拟中间设备截断流，检验拆包器和重连的恢复
+ * 以上概率都按每次读取计算；一个注入器可以被多个连接共享，随机数加锁生成
+ */
+class FaultInjector {
+public:
+    using Ptr = std::shared_ptr<FaultInjector>;
+
+    struct Config {
+        // 分片长度范围，0表示不分片
+        size_t chunk_min = 0;
+        size_t chunk_max = 0;
+        // 停顿概率及时长范围(ms)
+        double stall_prob = 0;
+        uint32_t stall_min_ms = 10;
+        uint32_t stall_max_ms = 500;
+        // 复位概率
+        double reset_prob = 0;
+        // 丢失概率及单次最多丢弃的字节数
+        double drop_prob = 0;
+        size_t drop_max = 64;
+        // 随机种子，0表示随机
+        uint64_t seed = 0;
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> chunks{0};
+        std::atomic<uint64_t> stalls{0};
+        std::atomic<uint64_t> resets{0};
+        std::atomic<uint64_t> drops{0};
+        std::atomic<uint64_t> dropped_bytes{0};
+    };
+
+    explicit FaultInjector(const Config& config)
+        : _config(config), _rng(config.seed ? config.seed : std::random_device()()) {
+        if (_config.chunk_max < _config.chunk_min) _config.chunk_max = _config.chunk_min;
+        if (_config.stall_max_ms < _config.stall_min_ms) _config.stall_max_ms = _config.stall_min_ms;
+    }
+
+    const Config& getConfig() const { return _config; }
+    const Stats& getStats() const { return _stats; }
+
+    /**
+     * 读取前调用，返回本次需要暂停读取的时长(ms)，0表示正常读取
+     */
+    uint32_t nextStall() {
+        if (_config.stall_prob <= 0 || !hit(_config.stall_prob)) return 0;
+        ++_stats.stalls;
+        return (uint32_t)uniform(_config.stall_min_ms, _config.stall_max_ms);
+    }
+
+    /**
+     * 读到数据后调用，返回true表示本次以RST断开
+     */
+    bool nextReset() {
+        if (_config.reset_prob <= 0 || !hit(_config.reset_prob)) return false;
+        ++_stats.resets;
+        return true;
+    }
+
+    /**
+     * 对一次读到的数据做丢失和分片，按顺序回调每一段
+     * @param on_chunk bool(const char* data, size_t len)，返回false时停止（连接已关闭）
+     */
+    template <typename OnChunk>
+    void deliver(const char* data, size_t len, OnChunk&& on_chunk) {
+        ++_stats.reads;
+        size_t drop_pos = len, drop_len = 0;
+        if (_config.drop_prob > 0 && len > 0 && hit(_config.drop_prob)) {
+            drop_pos = uniform(0, len - 1);
+            drop_len = std::min<size_t>(uniform(1, std::max<size_t>(_config.drop_max, 1)), len - drop_pos);
+            ++_stats.drops;
+            _stats.dropped_bytes += drop_len;
+        }
+
+        size_t pos = 0;
+        while (pos < len) {
+            if (pos == drop_pos) {
+                pos += drop_len;
+                continue;
+            }
+            size_t end = drop_pos > pos ? drop_pos : len;
+            size_t n = end - pos;
+            if (_config.chunk_max) n = std::min(n, uniform(std::max<size_t>(_config.chunk_min, 1), _config.chunk_max));
+            ++_stats.chunks;
+            if (!on_chunk(data + pos, n)) return;
+            pos += n;
+        }
+    }
+
+private:
+    bool hit(double prob) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::uniform_real_distribution<double>(0, 1)(_rng) < prob;
+    }
+
+    size_t uniform(size_t min, size_t max) {
+        if (min >= max) return min;
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::uniform_int_distribution<size_t>(min, max)(_rng);
+    }
+
+private:
+    Config _config;
+    Stats _stats;
+    std::mutex _mutex;
+    std::mt19937_64 _rng;
+};
+
+} // namespace toolkit
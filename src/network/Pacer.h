@@ -0,0 +1,313 @@
+#pragma once
+#include <memory>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "network/EventPoller.h"
+
+namespace toolkit {
+
+/**
+ * 平滑发送的一路输出，由所属loop的PacerScheduler驱动
+ */
+class PacedFlow {
+public:
+    using Ptr = std::shared_ptr<PacedFlow>;
+    virtual ~PacedFlow() = default;
+
+    /**
+     * 发送已到期的数据
+     * @return 下次需要调度的时间(us，steady clock)，没有待发数据时返回0
+     */
+    virtual int64_t poll(int64_t now_us) = 0;
+
+private:
+    friend class PacerScheduler;
+    // 调度器中的到期时间，0表示未在调度中
+    int64_t _due_us = 0;
+};
+
+/**
+ * 每个EventPoller一个调度器，所有会话共用一个timerfd，
+ * 定时器始终设置为最早到期的那一路，不为每个包创建定时器
+ * 各路按到期时间放在最小堆中，每次唤醒只处理已到期的，不遍历所有会话
+ * 时间轮精度为10ms，不足以把一帧摊到几十毫秒内，因此单独使用微秒精度的timerfd
+ * 只能在所属loop线程使用
+ */
+class PacerScheduler : public std::enable_shared_from_this<PacerScheduler> {
+public:
+    using Ptr = std::shared_ptr<PacerScheduler>;
+
+    /**
+     * 获取该loop的调度器，没有时创建；所有使用者都释放后随之销毁
+     * 必须在该loop线程调用
+     */
+    static Ptr get(const EventPoller::Ptr& poller) {
+        static std::mutex mutex;
+        static std::unordered_map<EventPoller*, std::weak_ptr<PacerScheduler>> schedulers;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& weak = schedulers[poller.get()];
+        auto ret = weak.lock();
+        if (!ret) {
+            ret.reset(new PacerScheduler(poller));
+            ret->init();
+            weak = ret;
+        }
+        return ret;
+    }
+
+    ~PacerScheduler() {
+        if (_timer_fd >= 0) {
+            _poller->delEvent(_timer_fd);
+            ::close(_timer_fd);
+        }
+    }
+
+    /**
+     * 请求在when_us调度flow，已在调度中的flow只会提前、不会推迟
+     */
+    void schedule(const PacedFlow::Ptr& flow, int64_t when_us) {
+        if (flow->_due_us && flow->_due_us <= when_us) return;
+        // 原来较晚的堆项留在堆中，弹出时与_due_us不符而被跳过
+        flow->_due_us = when_us;
+        _heap.push(Entry{when_us, flow});
+        arm(when_us);
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    struct Entry {
+        int64_t when_us;
+        std::weak_ptr<PacedFlow> flow;
+
+        bool operator>(const Entry& other) const { return when_us > other.when_us; }
+    };
+
+    explicit PacerScheduler(const EventPoller::Ptr& poller) : _poller(poller) {}
+
+    void init() {
+        _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (_timer_fd < 0) return;
+        // 回调期间持有强引用：flow发送失败时会话及其队列可能被销毁，连带释放最后一个调度器引用
+        std::weak_ptr<PacerScheduler> weak_self = shared_from_this();
+        _poller->addEvent(_timer_fd, EventPoller::Event_Read, [weak_self](int) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onTimer();
+            }
+        });
+    }
+
+    void arm(int64_t when_us) {
+        if (_timer_fd < 0) return;
+        if (_armed_us && _armed_us <= when_us) return;
+        _armed_us = when_us;
+        struct itimerspec its{};
+        // steady_clock即CLOCK_MONOTONIC；0会解除定时器，至少为1ns
+        its.it_value.tv_sec = when_us / 1000000;
+        its.it_value.tv_nsec = (when_us % 1000000) * 1000 + 1;
+        timerfd_settime(_timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    void onTimer() {
+        uint64_t expirations;
+        ssize_t n = ::read(_timer_fd, &expirations, sizeof(expirations));
+        (void)n;
+        _armed_us = 0;
+
+        int64_t now = nowUs();
+        while (!_heap.empty() && _heap.top().when_us <= now) {
+            Entry entry = _heap.top();
+            _heap.pop();
+            auto flow = entry.flow.lock();
+            if (!flow || flow->_due_us != entry.when_us) continue;
+            flow->_due_us = 0;
+            // poll中可能调用schedule，只在更早时覆盖
+            int64_t when = flow->poll(now);
+            if (when && (flow->_due_us == 0 || when < flow->_due_us)) {
+                flow->_due_us = when;
+                _heap.push(Entry{when, flow});
+            }
+        }
+        // 丢弃堆顶的失效项，定时器设为下一个有效到期时间
+        while (!_heap.empty()) {
+            auto flow = _heap.top().flow.lock();
+            if (flow && flow->_due_us == _heap.top().when_us) break;
+            _heap.pop();
+        }
+        if (!_heap.empty()) arm(_heap.top().when_us);
+    }
+
+private:
+    EventPoller::Ptr _poller;
+    int _timer_fd = -1;
+    int64_t _armed_us = 0;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _heap;
+};
+
+/**
+ * 单个会话的发送队列，按令牌桶平滑输出
+ * 1. 桶深burst_bytes，空闲时积累的令牌允许立即发出一小段，之后按速率放行
+ * 2. 速率按帧自适应：RTP时间戳变化视为新的一帧，帧间隔由相邻两帧的时间戳差得到，
+ *    该帧的包要在 首包入队时间+帧间隔 之前发完，速率取 积压字节/剩余时间，
+ *    关键帧的几百KB因此摊到一个帧间隔内，而不是一次性写进socket
+ * 3. 可选最低/最高速率限制
+ * 只能在所属loop线程使用
+ */
+template <typename T>
+class PacedQueue : public PacedFlow, public std::enable_shared_from_this<PacedQueue<T>> {
+public:
+    using Ptr = std::shared_ptr<PacedQueue>;
+    using Sink = std::function<void(const T&)>;
+
+    struct Config {
+        // 突发上限（字节）
+        size_t burst_bytes = 16 * 1024;
+        // 最低/最高速率（字节/秒），0表示不限制
+        uint64_t min_rate = 0;
+        uint64_t max_rate = 0;
+        // RTP时钟频率，用于由时间戳差计算帧间隔
+        uint32_t clock_rate = 90000;
+        // 帧间隔(us)：未知时的默认值和上限，上限防止时间戳跳变导致长时间积压
+        int64_t default_interval_us = 40000;
+        int64_t max_interval_us = 200000;
+    };
+
+    PacedQueue(const EventPoller::Ptr& poller, const Config& config, Sink sink)
+        : _config(config), _scheduler(PacerScheduler::get(poller)), _sink(std::move(sink)),
+          _tokens((int64_t)config.burst_bytes), _last_refill_us(PacerScheduler::nowUs()),
+          _interval_us(config.default_interval_us) {}
+
+    /**
+     * 入队，队列为空且令牌足够时直接发送
+     * @param bytes 该数据的发送字节数
+     * @param timestamp RTP时间戳
+     */
+    void push(T item, size_t bytes, uint32_t timestamp) {
+        if (!_sink) return;
+        int64_t now = PacerScheduler::nowUs();
+        if (!_have_frame || timestamp != _last_timestamp) {
+            if (_have_frame) {
+                int32_t delta = (int32_t)(timestamp - _last_timestamp);
+                if (delta > 0) {
+                    _interval_us = std::min<int64_t>((int64_t)delta * 1000000 / _config.clock_rate,
+                                                     _config.max_interval_us);
+                }
+            }
+            _have_frame = true;
+            _last_timestamp = timestamp;
+            _frame_deadline = now + _interval_us;
+        }
+
+        refill(now);
+        if (_queue.empty() && _tokens >= (int64_t)bytes) {
+            _tokens -= bytes;
+            _sink(item);
+            return;
+        }
+        _queue.push_back(Entry{std::move(item), bytes, _frame_deadline});
+        _queued_bytes += bytes;
+        _scheduler->schedule(this->shared_from_this(), nextSendTime(now));
+    }
+
+    /**
+     * 丢弃所有排队数据并停止回调，会话关闭时调用
+     */
+    void stop() {
+        _sink = nullptr;
+        _queue.clear();
+        _queued_bytes = 0;
+    }
+
+    /**
+     * 清空排队数据，保留令牌和帧间隔
+     */
+    void clear() {
+        _queue.clear();
+        _queued_bytes = 0;
+    }
+
+    size_t queuedBytes() const { return _queued_bytes; }
+
+    int64_t poll(int64_t now_us) override {
+        refill(now_us);
+        while (_sink && !_queue.empty() && _tokens >= (int64_t)_queue.front().bytes) {
+            Entry entry = std::move(_queue.front());
+            _queue.pop_front();
+            _queued_bytes -= entry.bytes;
+            _tokens -= entry.bytes;
+            _sink(entry.item);
+        }
+        if (!_sink || _queue.empty()) return 0;
+        return nextSendTime(now_us);
+    }
+
+private:
+    struct Entry {
+        T item;
+        size_t bytes;
+        int64_t deadline_us;
+    };
+
+    // 当前放行速率（字节/秒）：保证队尾所在帧按期发完
+    uint64_t currentRate(int64_t now_us) const {
+        uint64_t rate = _config.min_rate;
+        if (!_queue.empty()) {
+            int64_t remain = std::max<int64_t>(_queue.back().deadline_us - now_us, kMinStepUs);
+            rate = std::max<uint64_t>(rate, (uint64_t)_queued_bytes * 1000000 / remain);
+        }
+        if (_config.max_rate) rate = std::min(rate, _config.max_rate);
+        return rate;
+    }
+
+    void refill(int64_t now_us) {
+        int64_t elapsed = now_us - _last_refill_us;
+        _last_refill_us = now_us;
+        if (_queue.empty()) {
+            // 空闲时一个帧间隔回满（设置了最高速率时按最高速率），同一帧内不会因队列暂时排空而重新获得整桶令牌
+            uint64_t rate = _config.max_rate ? _config.max_rate
+                                             : (uint64_t)_config.burst_bytes * 1000000 / std::max<int64_t>(_interval_us, 1);
+            _tokens += (int64_t)(rate * elapsed / 1000000);
+        } else {
+            _tokens += (int64_t)(currentRate(now_us) * elapsed / 1000000);
+        }
+        _tokens = std::min<int64_t>(_tokens, std::max<int64_t>(_config.burst_bytes, _queue.empty() ? 0 : _queue.front().bytes));
+    }
+
+    int64_t nextSendTime(int64_t now_us) const {
+        int64_t need = (int64_t)_queue.front().bytes - _tokens;
+        if (need <= 0) return now_us + kMinStepUs;
+        uint64_t rate = std::max<uint64_t>(currentRate(now_us), 1);
+        return now_us + std::max<int64_t>((int64_t)(need * 1000000 / rate), kMinStepUs);
+    }
+
+private:
+    // 调度最小步长，限制每个会话的唤醒频率
+    static constexpr int64_t kMinStepUs = 500;
+
+    Config _config;
+    PacerScheduler::Ptr _scheduler;
+    Sink _sink;
+    std::deque<Entry> _queue;
+    size_t _queued_bytes = 0;
+    int64_t _tokens;
+    int64_t _last_refill_us;
+
+    bool _have_frame = false;
+    uint32_t _last_timestamp = 0;
+    int64_t _interval_us;
+    int64_t _frame_deadline = 0;
+};
+
+} // namespace toolkit
@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include "util/Logger.h"
+
+// 内核TLS(kTLS)的recvmsg控制消息，旧版本头文件中可能没有
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TLS_GET_RECORD_TYPE
+#define TLS_GET_RECORD_TYPE 2
+#endif
+
+namespace toolkit {
+
+/**
+ * TLS客户端上下文，进程内共享一个SSL_CTX
+ * 1. 会话恢复：按host:port缓存服务端下发的会话（session id/ticket），重连时只需一次简化握手
+ * 2. 内核TLS：OpenSSL与内核都支持时握手后把记录加解密交给内核，
+ *    收包直接recvmsg得到明文，不经过OpenSSL的读缓冲
+ */
+class SslContext {
+public:
+    struct Config {
+        // 校验服务端证书和主机名；摄像头大多是自签名证书，默认不校验（与ffmpeg的rtsps默认行为一致）
+        bool verify = false;
+        // CA证书文件，为空时使用系统默认路径
+        std::string ca_file;
+        // 允许使用内核TLS
+        bool ktls = true;
+        // 会话缓存上限（主机数）
+        size_t max_sessions = 4096;
+    };
+
+    /**
+     * 设置配置，必须在第一次调用Instance()之前设置
+     */
+    static void setConfig(const Config& config) {
+        configRef() = config;
+    }
+
+    static SslContext& Instance() {
+        static SslContext* instance = new SslContext(configRef());
+        return *instance;
+    }
+
+    /**
+     * 为一次连接创建SSL对象，设置SNI、主机名校验，并带上缓存的会话
+     * @return 失败返回nullptr
+     */
+    SSL* createClient(const std::string& host, uint16_t port) {
+        if (!_ctx) return nullptr;
+        SSL* ssl = SSL_new(_ctx);
+        if (!ssl) return nullptr;
+
+        std::string key = host + ":" + std::to_string(port);
+        SSL_set_ex_data(ssl, _key_index, new std::string(key));
+        if (!isIP(host)) SSL_set_tlsext_host_name(ssl, host.c_str());
+        if (_config.verify) SSL_set1_host(ssl, host.c_str());
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _sessions.find(key);
+        if (it != _sessions.end()) SSL_set_session(ssl, it->second);
+        return ssl;
+    }
+
+    /**
+     * 取出并清空当前线程的OpenSSL错误队列
+     */
+    static std::string lastError() {
+        std::string ret;
+        unsigned long err;
+        while ((err = ERR_get_error()) != 0) {
+            char buf[256];
+            ERR_error_string_n(err, buf, sizeof(buf));
+            if (!ret.empty()) ret += "; ";
+            ret += buf;
+        }
+        return ret.empty() ? "unknown error" : ret;
+    }
+
+    size_t sessionCount() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _sessions.size();
+    }
+
+private:
+    explicit SslContext(const Config& config) : _config(config) {
+        _ctx = SSL_CTX_new(TLS_client_method());
+        if (!_ctx) {
+            ErrorL("SSL_CTX_new failed: %s", lastError().c_str());
+            return;
+        }
+        SSL_CTX_set_min_proto_version(_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_mode(_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_ENABLE_KTLS
+        if (_config.ktls) SSL_CTX_set_options(_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+        if (_config.verify) {
+            SSL_CTX_set_verify(_ctx, SSL_VERIFY_PEER, nullptr);
+            if (_config.ca_file.empty() ? SSL_CTX_set_default_verify_paths(_ctx) != 1
+                                        : SSL_CTX_load_verify_locations(_ctx, _config.ca_file.c_str(), nullptr) != 1) {
+                WarnL("load CA failed: %s", lastError().c_str());
+            }
+        } else {
+            SSL_CTX_set_verify(_ctx, SSL_VERIFY_NONE, nullptr);
+        }
+
+        // 会话只存在自己的缓存里，按host:port查找
+        _key_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, freeKey);
+        SSL_CTX_set_session_cache_mode(_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(_ctx, onNewSession);
+    }
+
+    static Config& configRef() {
+        static Config config;
+        return config;
+    }
+
+    static bool isIP(const std::string& host) {
+        unsigned char buf[sizeof(struct in6_addr)];
+        return inet_pton(AF_INET, host.c_str(), buf) == 1 || inet_pton(AF_INET6, host.c_str(), buf) == 1;
+    }
+
+    static void freeKey(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+        delete (std::string*)ptr;
+    }
+
+    // 握手完成或TLS1.3收到新ticket时回调，返回1表示接管sess的引用
+    static int onNewSession(SSL* ssl, SSL_SESSION* sess) {
+        auto& self = Instance();
+        auto key = (std::string*)SSL_get_ex_data(ssl, self._key_index);
+        if (!key || !SSL_SESSION_is_resumable(sess)) return 0;
+
+        std::lock_guard<std::mutex> lock(self._mutex);
+        auto it = self._sessions.find(*key);
+        if (it != self._sessions.end()) {
+            SSL_SESSION_free(it->second);
+            it->second = sess;
+            return 1;
+        }
+        if (self._sessions.size() >= self._config.max_sessions) {
+            SSL_SESSION_free(self._sessions.begin()->second);
+            self._sessions.erase(self._sessions.begin());
+        }
+        self._sessions.emplace(*key, sess);
+        return 1;
+    }
+
+private:
+    Config _config;
+    SSL_CTX* _ctx = nullptr;
+    int _key_index = -1;
+    std::mutex _mutex;
+    std::unordered_map<std::string, SSL_SESSION*> _sessions;
+};
+
+} // namespace toolkit
@@ -1,11 +1,16 @@
 #pragma once
 #include <memory>
 #include <string>
-#include <thread>
 #include <atomic>
+#include <mutex>
 #include <functional>
-#include <poll.h>
+#include <chrono>
+#include <sys/uio.h>
 #include <unistd.h>
+#include "network/EventPollerPool.h"
+#include "network/SslContext.h"
+#include "network/FaultInjector.h"
+#include "network/DnsResolver.h"
 #include "util/SockException.h"
 #include "util/SockUtil.h"
 #include "util/Buffer.h"
@@ -15,6 +20,8 @@ namespace toolkit {
 /**
  * TCP客户端基类（参考ZLToolKit的TcpClient）
  * 子类需要重写 onConnect, onRecv, onError 回调
+ * 连接和收包都由EventPollerPool中的一个loop负责，onConnect/onRecv/onError在该loop线程执行
+ * 对象必须由shared_ptr管理
  */
 class TcpClient : public std::enable_shared_from_this<TcpClient> {
 public:
@@ -24,51 +31,84 @@ public:
     virtual ~TcpClient() { shutdown(); }
 
     /**
-     * 开始连接TCP服务器
-     * @param host 服务器IP或域名
-     * @param port 服务器端口
-     * @param timeout_sec 超时时间（秒）
+     * 指定收包的loop，不指定时从EventPollerPool选择，
+     * 开启steer_by_incoming_cpu时连接成功后会迁移到处理该连接网卡队列的loop
      */
-    void startConnect(const std::string& host, uint16_t port, float timeout_sec = 5.0f) {
-        shutdown();
+    void setPoller(const EventPoller::Ptr& poller) {
+        std::lock_guard<std::mutex> lock(_poller_mutex);
+        _poller = poller;
+        _poller_fixed = poller != nullptr;
+    }
 
-        _host = host;
-        _port = port;
+    /**
+     * 当前负责该连接的loop，连接成功后可能迁移，可在任意线程调用
+     */
+    EventPoller::Ptr getPoller() const {
+        std::lock_guard<std::mutex> lock(_poller_mutex);
+        return _poller;
+    }
 
-        // 异步连接
-        _fd = SockUtil::connect(host.c_str(), port, true);
-        if (_fd < 0) {
-            onConnect(SockException(Err_dns, "connect failed"));
-            return;
-        }
+    /**
+     * 开启内核接收时间戳，必须在startConnect之前调用
+     * 开启后用recvmsg读取，onRecv期间可通过getRecvTime()获取
+     */
+    void setRecvTimestamp(bool enable) { _recv_timestamp = enable; }
 
-        // 等待连接完成
-        struct pollfd pfd{};
-        pfd.fd = _fd;
-        pfd.events = POLLOUT;
+    /**
+     * 低延时模式，必须在startConnect之前调用
+     * 连接运行在EventPollerPool的忙轮询loop上（除非setPoller指定），并设置忙轮询、QUICKACK等socket选项
+     */
+    void setLowLatency(bool enable, const SockUtil::LowLatencyOptions& opt = SockUtil::LowLatencyOptions()) {
+        _low_latency = enable;
+        _low_latency_opt = opt;
+    }
 
-        int ret = poll(&pfd, 1, (int)(timeout_sec * 1000));
-        if (ret <= 0) {
-            ::close(_fd);
-            _fd = -1;
-            onConnect(SockException(Err_timeout, "connect timeout"));
-            return;
-        }
+    /**
+     * 开启TLS，必须在startConnect之前调用
+     * TCP连接后在同一个loop上非阻塞握手，握手完成才回调onConnect，connect超时包含握手时间
+     */
+    void setTls(bool enable) { _tls = enable; }
+    bool isTls() const { return _tls; }
 
-        // 检查连接结果
-        int err = SockUtil::getSockError(_fd);
-        if (err != 0) {
-            ::close(_fd);
-            _fd = -1;
-            onConnect(SockException(Err_refused, strerror(err)));
-            return;
-        }
+    /**
+     * 收包故障注入（分片、停顿、复位、丢失），仅用于测试，必须在startConnect之前调用
+     */
+    void setFaultInjector(const FaultInjector::Ptr& injector) { _fault = injector; }
 
-        // 连接成功，启动接收线程
-        _running = true;
-        _recv_thread = std::thread([this]() { recvLoop(); });
+    // 本次连接是否复用了缓存的TLS会话
+    bool tlsSessionReused() const { return _ssl && SSL_session_reused(_ssl); }
+
+    // 本次连接的TLS接收是否由内核解密
+    bool tlsKernelRecv() const { return _ktls_recv; }
+
+    /**
+     * 开始连接TCP服务器，可在任意线程调用，连接过程整体投递到loop上执行，onConnect在loop线程回调
+     * 域名在DnsResolver线程上解析，不阻塞loop；IP和缓存命中时直接连接
+     * @param host 服务器IP或域名
+     * @param port 服务器端口
+     * @param timeout_sec 超时时间（秒，包含解析），由loop的时间轮计时
+     */
+    void startConnect(const std::string& host, uint16_t port, float timeout_sec = 5.0f) {
+        shutdown();
 
-        onConnect(SockException(Err_success, "success"));
+        EventPoller::Ptr poller;
+        {
+            std::lock_guard<std::mutex> lock(_poller_mutex);
+            if (!_poller) {
+                _poller = _low_latency ? EventPollerPool::Instance().getLowLatencyPoller()
+                                       : EventPollerPool::Instance().getPoller(false);
+            }
+            poller = _poller;
+        }
+
+        uint64_t token = ++_connect_token;
+        std::weak_ptr<TcpClient> weak_self = shared_from_this();
+        poller->async([weak_self, host, port, timeout_sec, token]() {
+            auto strong_self = weak_self.lock();
+            // 投递期间已被shutdown或重新发起连接
+            if (!strong_self || strong_self->_connect_token != token) return;
+            strong_self->connectOnLoop(host, port, timeout_sec, token);
+        });
     }
 
     /**
@@ -80,6 +120,12 @@ public:
 
     ssize_t send(const char* data, size_t len) {
         if (_fd < 0 || !_running) return -1;
+        if (_ssl) {
+            // 开启内核TLS发送时OpenSSL内部直接send明文
+            ERR_clear_error();
+            int n = SSL_write(_ssl, data, (int)len);
+            return n > 0 ? n : -1;
+        }
         return ::send(_fd, data, len, MSG_NOSIGNAL);
     }
 
@@ -90,25 +136,18 @@ public:
     /**
      * 主动断开连接
      */
-    void shutdown(const SockException& ex = SockException(Err_shutdown, "self shutdown")) {
-        if (!_running && _fd < 0) return;
-
-        _running = false;
-
-        if (_fd >= 0) {
-            ::shutdown(_fd, SHUT_RDWR);
-            ::close(_fd);
-            _fd = -1;
-        }
-
-        // 等待接收线程结束
-        if (_recv_thread.joinable()) {
-            if (_recv_thread.get_id() != std::this_thread::get_id()) {
-                _recv_thread.join();
-            } else {
-                _recv_thread.detach();
-            }
+    void shutdown(const SockException& /*ex*/ = SockException(Err_shutdown, "self shutdown")) {
+        // 作废已投递尚未执行的连接
+        ++_connect_token;
+        if (!_running && _fd < 0 && !_resolving) return;
+
+        auto poller = getPoller();
+        if (!poller) {
+            closeSock();
+            return;
         }
+        // 在loop线程关闭，避免与正在执行的收包回调竞争
+        poller->sync([this]() { closeSock(); });
     }
 
     /**
@@ -144,50 +183,391 @@ protected:
     /**
      * 连接断开回调
      */
-    virtual void onError(const SockException& ex) {
+    virtual void onError(const SockException& /*ex*/) {
         // 默认空实现，子类可重写
     }
 
+    /**
+     * 当前onRecv数据的内核接收时间（unix时间，ns），未开启时为0
+     * TCP一次读取可能包含多个报文，时间戳为其中最后一个报文的到达时间
+     */
+    int64_t getRecvTime() const { return _recv_time_ns; }
+
 private:
-    void recvLoop() {
-        auto buf = std::make_shared<BufferRaw>();
-        buf->setCapacity(64 * 1024);  // 64KB接收缓冲
+    // loop线程：启动超时计时，解析（或查缓存）后发起连接
+    void connectOnLoop(const std::string& host, uint16_t port, float timeout_sec, uint64_t token) {
+        _host = host;
+        _port = port;
+        std::weak_ptr<TcpClient> weak_self = shared_from_this();
+        _connect_timer = _poller->doDelayTask((uint64_t)(timeout_sec * 1000), [weak_self, token]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (strong_self && strong_self->_connect_token == token && !strong_self->_running &&
+                (strong_self->_fd >= 0 || strong_self->_resolving)) {
+                strong_self->closeSock();
+                strong_self->onConnect(SockException(Err_timeout, "connect timeout"));
+            }
+            return 0;
+        });
+
+        sockaddr_storage addr;
+        bool failed = false;
+        if (DnsResolver::Instance().lookup(host, port, addr, failed)) {
+            if (failed) {
+                closeSock();
+                onConnect(SockException(Err_dns, "resolve " + host + " failed (cached)"));
+                return;
+            }
+            connectAddr(addr);
+            return;
+        }
 
-        while (_running && _fd >= 0) {
-            struct pollfd pfd{};
-            pfd.fd = _fd;
-            pfd.events = POLLIN | POLLERR | POLLHUP;
+        _resolving = true;
+        auto poller = _poller;
+        DnsResolver::Instance().resolve(host, port, [weak_self, poller, token, host](bool ok, const sockaddr_storage& addr) {
+            poller->async([weak_self, token, host, ok, addr]() {
+                auto strong_self = weak_self.lock();
+                // 解析期间已被shutdown或重新发起连接
+                if (!strong_self || strong_self->_connect_token != token || !strong_self->_resolving) return;
+                strong_self->_resolving = false;
+                if (!ok) {
+                    strong_self->closeSock();
+                    strong_self->onConnect(SockException(Err_dns, "resolve " + host + " failed"));
+                    return;
+                }
+                strong_self->connectAddr(addr);
+            }, false);
+        });
+    }
 
-            int ret = poll(&pfd, 1, 100);  // 100ms超时
-            if (ret < 0) {
-                if (errno == EINTR) continue;
-                onError(SockException(Err_other, strerror(errno)));
-                break;
+    // 发起异步连接，在loop线程调用
+    void connectAddr(const sockaddr_storage& addr) {
+        // 选项在connect之前设置：SO_RCVBUF决定SYN中的窗口扩大因子，握手后再设置只会缩小可用窗口
+        int fd = SockUtil::connect(addr, true, [this](int fd) {
+            if (_recv_timestamp) {
+                SockUtil::setRecvTimestamp(fd);
+            }
+            if (_low_latency) {
+                auto opt = _low_latency_opt;
+                if (opt.incoming_cpu < 0 && !_poller->getCpus().empty()) {
+                    opt.incoming_cpu = _poller->getCpus().cpus().front();
+                }
+                SockUtil::setLowLatency(fd, opt);
+            }
+        });
+        if (fd < 0) {
+            int err = errno;
+            closeSock();
+            onConnect(SockException(Err_refused, std::string("connect failed: ") + strerror(err)));
+            return;
+        }
+        _fd = fd;
+        // 等待可写，即连接完成
+        _poller->addEvent(fd, EventPoller::Event_Write | EventPoller::Event_Error, makeEventCB(fd));
+    }
+
+    EventPoller::PollEventCB makeEventCB(int fd) {
+        std::weak_ptr<TcpClient> weak_self = shared_from_this();
+        return [weak_self, fd](int event) {
+            auto strong_self = weak_self.lock();
+            if (!strong_self || strong_self->_fd != fd) return;
+            if (strong_self->_running) {
+                strong_self->onEvent(event);
+            } else if (strong_self->_ssl) {
+                strong_self->onHandshake(event);
+            } else {
+                strong_self->onConnected(event);
             }
+        };
+    }
 
-            if (ret == 0) continue;  // 超时
+    void onConnected(int event) {
+        int err = SockUtil::getSockError(_fd);
+        if (err != 0 || (event & EventPoller::Event_Error)) {
+            closeSock();
+            onConnect(SockException(Err_refused, strerror(err ? err : ECONNREFUSED)));
+            return;
+        }
+        if (_tls) {
+            _ssl = SslContext::Instance().createClient(_host, _port);
+            if (!_ssl || SSL_set_fd(_ssl, _fd) != 1) {
+                closeSock();
+                onConnect(SockException(Err_other, "create ssl failed: " + SslContext::lastError()));
+                return;
+            }
+            onHandshake(EventPoller::Event_Write);
+            return;
+        }
+        onReady();
+    }
 
-            if (pfd.revents & (POLLERR | POLLHUP)) {
-                onError(SockException(Err_eof, "connection closed"));
-                break;
+    void onHandshake(int event) {
+        if (event & EventPoller::Event_Error) {
+            int err = SockUtil::getSockError(_fd);
+            closeSock();
+            onConnect(SockException(Err_eof, std::string("tls handshake: ") + strerror(err ? err : ECONNRESET)));
+            return;
+        }
+        ERR_clear_error();
+        int ret = SSL_connect(_ssl);
+        if (ret != 1) {
+            int err = SSL_get_error(_ssl, ret);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                int wait = err == SSL_ERROR_WANT_READ ? EventPoller::Event_Read : EventPoller::Event_Write;
+                _poller->modifyEvent(_fd, wait | EventPoller::Event_Error);
+                return;
             }
+            std::string msg = "tls handshake failed: " + SslContext::lastError();
+            closeSock();
+            onConnect(SockException(Err_other, msg));
+            return;
+        }
+        // OpenSSL在握手结束时尝试开启内核TLS，成功后读路径绕过SSL_read
+#ifdef BIO_get_ktls_recv
+        _ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(_ssl));
+#else
+        _ktls_recv = false;
+#endif
+        onReady();
+    }
 
-            if (pfd.revents & POLLIN) {
-                ssize_t n = ::recv(_fd, buf->data(), buf->getCapacity(), 0);
+    // TCP连接（及TLS握手）完成
+    void onReady() {
+        if (_connect_timer) {
+            _connect_timer->cancel();
+            _connect_timer = nullptr;
+        }
+        _running = true;
+
+        int fd = _fd;
+        bool keep = _poller_fixed || _low_latency;
+        auto poller = keep ? _poller : EventPollerPool::Instance().getPollerForSock(fd);
+        if (poller == _poller) {
+            _poller->modifyEvent(fd, EventPoller::Event_Read | EventPoller::Event_Error);
+            onConnect(SockException(Err_success, "success"));
+            return;
+        }
+
+        // 迁移到处理该连接网卡队列的loop，之后的回调都在新loop执行
+        _poller->delEvent(fd);
+        {
+            std::lock_guard<std::mutex> lock(_poller_mutex);
+            _poller = poller;
+        }
+        std::weak_ptr<TcpClient> weak_self = shared_from_this();
+        poller->async([weak_self, fd]() {
+            auto strong_self = weak_self.lock();
+            if (!strong_self || strong_self->_fd != fd) return;
+            strong_self->_poller->addEvent(fd, EventPoller::Event_Read | EventPoller::Event_Error,
+                                           strong_self->makeEventCB(fd));
+            strong_self->onConnect(SockException(Err_success, "success"));
+        }, false);
+    }
+
+    void onEvent(int event) {
+        if (event & EventPoller::Event_Read) {
+            if (_fault && stallRead()) return;
+            auto& buf = _poller->getSharedBuffer();
+            while (_running && _fd >= 0) {
+                ssize_t n = readSome(buf);
+                if (n == kRetry) continue;
                 if (n > 0) {
+                    if (_low_latency && _low_latency_opt.quickack) {
+                        SockUtil::setQuickAck(_fd);
+                    }
                     buf->setSize(n);
-                    onRecv(buf);
-                } else if (n == 0) {
-                    onError(SockException(Err_eof, "peer closed"));
-                    break;
-                } else {
-                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                        continue;
+                    if (_fault) {
+                        if (!injectRecv(buf)) return;
+                    } else {
+                        onRecv(buf);
                     }
-                    onError(SockException(Err_other, strerror(errno)));
-                    break;
+                    // SSL_read每次最多返回一条记录，读到EAGAIN为止
+                    if ((size_t)n < buf->getCapacity() && (!_ssl || _ktls_recv)) break;
+                    continue;
+                }
+                if (n == 0) {
+                    closeSock();
+                    onError(SockException(Err_eof, "peer closed"));
+                    return;
                 }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                int err = errno;
+                closeSock();
+                onError(SockException(Err_other, strerror(err)));
+                return;
+            }
+        }
+
+        if ((event & EventPoller::Event_Error) && _fd >= 0) {
+            closeSock();
+            onError(SockException(Err_eof, "connection closed"));
+        }
+    }
+
+    // 故障注入：按概率暂停监听读事件，到期后恢复，期间数据留在内核缓冲
+    bool stallRead() {
+        uint32_t ms = _fault->nextStall();
+        if (!ms) return false;
+        int fd = _fd;
+        _poller->modifyEvent(fd, EventPoller::Event_Error);
+        std::weak_ptr<TcpClient> weak_self = shared_from_this();
+        _fault_timer = _poller->doDelayTask(ms, [weak_self, fd]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (strong_self && strong_self->_fd == fd && strong_self->_running) {
+                strong_self->_fault_timer = nullptr;
+                strong_self->_poller->modifyEvent(fd, EventPoller::Event_Read | EventPoller::Event_Error);
+            }
+            return 0;
+        });
+        return true;
+    }
+
+    // 故障注入：复位或丢失、分片后逐段回调onRecv，连接已关闭时返回false
+    bool injectRecv(const BufferRaw::Ptr& buf) {
+        if (_fault->nextReset()) {
+            SockUtil::setCloseWait(_fd, 0);
+            closeSock();
+            onError(SockException(Err_reset, "injected reset"));
+            return false;
+        }
+        int fd = _fd;
+        if (!_fault_buf) _fault_buf = std::make_shared<BufferRaw>();
+        _fault->deliver(buf->data(), buf->size(), [this, fd](const char* data, size_t len) {
+            _fault_buf->assign(data, len);
+            onRecv(_fault_buf);
+            return _fd == fd && _running;
+        });
+        return _fd == fd && _running;
+    }
+
+    // 读取一次，返回值同recv；kRetry表示读到的是需要跳过的非数据记录
+    static constexpr ssize_t kRetry = -2;
+    // TLS记录类型
+    static constexpr int kTlsAlert = 21;
+    static constexpr int kTlsHandshake = 22;
+    static constexpr int kTlsNewSessionTicket = 4;
+    static constexpr int kTlsApplicationData = 23;
+
+    ssize_t readSome(const BufferRaw::Ptr& buf) {
+        // 开启内核TLS前OpenSSL可能已读入部分记录，先由OpenSSL处理完
+        if (_ssl && (!_ktls_recv || SSL_has_pending(_ssl))) return sslRead(buf);
+        if (_recv_timestamp || _ktls_recv) return recvMsg(buf);
+        return ::recv(_fd, buf->data(), buf->getCapacity(), 0);
+    }
+
+    ssize_t sslRead(const BufferRaw::Ptr& buf) {
+        ERR_clear_error();
+        int n = SSL_read(_ssl, buf->data(), (int)buf->getCapacity());
+        if (n > 0) {
+            if (_recv_timestamp) {
+                // 数据经过OpenSSL缓冲，内核时间戳不再对应，退化为用户态时间
+                _recv_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
             }
+            return n;
+        }
+        switch (SSL_get_error(_ssl, n)) {
+            case SSL_ERROR_ZERO_RETURN:
+                return 0;
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                errno = EAGAIN;
+                return -1;
+            case SSL_ERROR_SYSCALL:
+                if (errno == 0) return 0;
+                return -1;
+            default:
+                WarnL("%s:%d SSL_read failed: %s", _host.c_str(), (int)_port, SslContext::lastError().c_str());
+                errno = EPROTO;
+                return -1;
+        }
+    }
+
+    // 握手记录中的消息（1字节类型 + 3字节长度）是否都是NewSessionTicket
+    static bool onlySessionTickets(const char* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        size_t pos = 0;
+        while (pos + 4 <= len) {
+            if (p[pos] != kTlsNewSessionTicket) return false;
+            pos += 4 + ((size_t)p[pos + 1] << 16 | (size_t)p[pos + 2] << 8 | p[pos + 3]);
+        }
+        return pos == len && len > 0;
+    }
+
+    /**
+     * recvmsg读取，附带内核接收时间戳和内核TLS的记录类型
+     */
+    ssize_t recvMsg(const BufferRaw::Ptr& buf) {
+        struct iovec iov;
+        iov.iov_base = buf->data();
+        iov.iov_len = buf->getCapacity();
+        char control[CMSG_SPACE(sizeof(struct timespec) * 3) + CMSG_SPACE(sizeof(unsigned char))];
+        struct msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n = ::recvmsg(_fd, &msg, 0);
+        if (n <= 0) return n;
+
+        _recv_time_ns = 0;
+        int record_type = kTlsApplicationData;
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+                record_type = *(unsigned char*)CMSG_DATA(cmsg);
+                continue;
+            }
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                // scm_timestamping: ts[0]软件时间戳，ts[2]硬件时间戳
+                struct timespec ts[3];
+                memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+                _recv_time_ns = (int64_t)ts[0].tv_sec * 1000000000 + ts[0].tv_nsec;
+            }
+        }
+        if (record_type != kTlsApplicationData) {
+            // 告警视为对端关闭
+            if (record_type == kTlsAlert) return 0;
+            // 只有TLS1.3的NewSessionTicket可以跳过（该连接上不再更新会话缓存）；
+            // KeyUpdate等其他握手消息之后内核无法解密后续记录，不能静默丢弃，按协议错误断开
+            if (record_type == kTlsHandshake && onlySessionTickets(buf->data(), (size_t)n)) return kRetry;
+            WarnL("%s:%d unexpected tls record (type %d) with kernel tls recv, closing",
+                  _host.c_str(), (int)_port, record_type);
+            errno = EPROTO;
+            return -1;
+        }
+        if (_recv_timestamp && _recv_time_ns == 0) {
+            // 内核不支持时退化为用户态时间
+            _recv_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        return n;
+    }
+
+    void closeSock() {
+        bool running = _running;
+        _running = false;
+        _resolving = false;
+        if (_connect_timer) {
+            _connect_timer->cancel();
+            _connect_timer = nullptr;
+        }
+        if (_fault_timer) {
+            _fault_timer->cancel();
+            _fault_timer = nullptr;
+        }
+        if (_ssl) {
+            // 尽力发送close_notify，不等待对端回复
+            if (running) SSL_shutdown(_ssl);
+            SSL_free(_ssl);
+            _ssl = nullptr;
+            _ktls_recv = false;
+        }
+        if (_fd >= 0) {
+            if (_poller) _poller->delEvent(_fd);
+            ::shutdown(_fd, SHUT_RDWR);
+            ::close(_fd);
+            _fd = -1;
         }
     }
 
@@ -198,7 +578,24 @@ protected:
 
 private:
     std::atomic<bool> _running{false};
-    std::thread _recv_thread;
+    bool _poller_fixed = false;
+    bool _recv_timestamp = false;
+    bool _low_latency = false;
+    SockUtil::LowLatencyOptions _low_latency_opt;
+    int64_t _recv_time_ns = 0;
+    bool _tls = false;
+    bool _ktls_recv = false;
+    SSL* _ssl = nullptr;
+    // loop线程内直接读取；其他线程经getPoller()，与startConnect和迁移时的赋值互斥
+    mutable std::mutex _poller_mutex;
+    EventPoller::Ptr _poller;
+    EventPoller::DelayTask::Ptr _connect_timer;
+    // 每次startConnect递增，丢弃过期的解析结果和超时
+    std::atomic<uint64_t> _connect_token{0};
+    std::atomic<bool> _resolving{false};
+    FaultInjector::Ptr _fault;
+    BufferRaw::Ptr _fault_buf;
+    EventPoller::DelayTask::Ptr _fault_timer;
 };
 
 } // namespace toolkit
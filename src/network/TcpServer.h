@@ -0,0 +1,376 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <sys/uio.h>
+#include <climits>
+#include "network/EventPollerPool.h"
+#include "util/SockException.h"
+#include "util/SockUtil.h"
+#include "util/Buffer.h"
+
+namespace toolkit {
+
+/**
+ * TCP服务端会话基类（参考ZLToolKit的Session）
+ * 所有回调和send都在所属EventPoller线程执行
+ * 发送队列只保存Buffer::Ptr，多个会话可以共享同一个Buffer，用writev批量发送
+ */
+class TcpSession : public std::enable_shared_from_this<TcpSession> {
+public:
+    using Ptr = std::shared_ptr<TcpSession>;
+
+    TcpSession(const EventPoller::Ptr& poller, int fd) : _poller(poller), _fd(fd) {}
+
+    virtual ~TcpSession() {
+        if (_fd >= 0) ::close(_fd);
+    }
+
+    /**
+     * 开始监听读事件，由TcpServer在创建会话后调用
+     */
+    void attachEvent() {
+        std::weak_ptr<TcpSession> weak_self = shared_from_this();
+        _poller->addEvent(_fd, EventPoller::Event_Read | EventPoller::Event_Error, [weak_self](int event) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onEvent(event);
+            }
+        });
+    }
+
+    /**
+     * 发送数据，必须在所属poller线程调用
+     * Buffer只增加引用计数，不拷贝
+     */
+    void send(Buffer::Ptr buf) {
+        if (_fd < 0 || !buf || buf->size() == 0) return;
+        _send_bytes += buf->size();
+        _send_queue.emplace_back(std::move(buf));
+        if (!_write_pending) flush();
+    }
+
+    void send(const std::string& data) {
+        send(std::make_shared<BufferString>(data));
+    }
+
+    /**
+     * 发送一个小头部 + 共享数据，必须在所属poller线程调用
+     * 发送队列为空时直接writev，全部写入内核则不产生任何内存分配；
+     * 只有写不完时才把剩余的头部拷贝入队
+     */
+    void send(const char* head, size_t head_len, const Buffer::Ptr& body) {
+        if (_fd < 0) return;
+        size_t body_len = body ? body->size() : 0;
+        if (!_send_queue.empty() || _write_pending) {
+            send(std::make_shared<BufferString>(head, head_len));
+            send(body);
+            return;
+        }
+
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<char*>(head);
+        iov[0].iov_len = head_len;
+        iov[1].iov_base = body_len ? body->data() : nullptr;
+        iov[1].iov_len = body_len;
+
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = body_len ? 2 : 1;
+        ssize_t n = ::sendmsg(_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                shutdown(SockException(Err_reset, strerror(errno)));
+                return;
+            }
+            n = 0;
+        }
+
+        size_t sent = n;
+        if (sent < head_len) {
+            send(std::make_shared<BufferString>(head + sent, head_len - sent));
+            send(body);
+            return;
+        }
+        sent -= head_len;
+        if (sent < body_len) {
+            _send_queue.emplace_back(body);
+            _send_offset = sent;
+            _send_bytes += body_len - sent;
+            flush();
+        }
+    }
+
+    /**
+     * 断开连接，会触发onError并从TcpServer移除
+     */
+    void shutdown(const SockException& ex = SockException(Err_shutdown, "self shutdown")) {
+        if (_fd < 0) return;
+        auto strong_self = shared_from_this();
+        _poller->delEvent(_fd);
+        ::shutdown(_fd, SHUT_RDWR);
+        ::close(_fd);
+        _fd = -1;
+        _send_queue.clear();
+        _send_bytes = 0;
+        onError(ex);
+        if (_on_detach) _on_detach(this);
+    }
+
+    /**
+     * 发送队列中尚未写入内核的字节数，用于慢消费者判断
+     */
+    size_t sendQueueBytes() const { return _send_bytes; }
+
+    bool alive() const { return _fd >= 0; }
+
+    const EventPoller::Ptr& getPoller() const { return _poller; }
+
+    std::string getPeerIP() const {
+        return _fd >= 0 ? SockUtil::getPeerIP(_fd) : "";
+    }
+
+    void setOnDetach(std::function<void(TcpSession*)> cb) { _on_detach = std::move(cb); }
+
+protected:
+    /**
+     * 收到数据回调（子类必须重写）
+     * buf为poller共享缓冲，回调返回后失效
+     */
+    virtual void onRecv(const Buffer::Ptr& buf) = 0;
+
+    /**
+     * 连接断开回调
+     */
+    virtual void onError(const SockException& /*ex*/) {
+        // 默认空实现，子类可重写
+    }
+
+    int rawFd() const { return _fd; }
+
+private:
+    void onEvent(int event) {
+        if (event & EventPoller::Event_Read) {
+            onRead();
+            if (_fd < 0) return;
+        }
+        if (event & EventPoller::Event_Write) {
+            flush();
+            if (_fd < 0) return;
+        }
+        if (event & EventPoller::Event_Error) {
+            shutdown(SockException(Err_eof, "connection closed"));
+        }
+    }
+
+    void onRead() {
+        auto& buf = _poller->getSharedBuffer();
+        while (_fd >= 0) {
+            ssize_t n = ::recv(_fd, buf->data(), buf->getCapacity(), 0);
+            if (n > 0) {
+                buf->setSize(n);
+                onRecv(buf);
+                if ((size_t)n < buf->getCapacity()) break;
+                continue;
+            }
+            if (n == 0) {
+                shutdown(SockException(Err_eof, "peer closed"));
+                return;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            shutdown(SockException(Err_reset, strerror(errno)));
+            return;
+        }
+    }
+
+    void flush() {
+        static constexpr size_t kMaxIov = 64;
+
+        while (_fd >= 0 && !_send_queue.empty()) {
+            struct iovec iov[kMaxIov];
+            size_t cnt = 0;
+            for (auto it = _send_queue.begin(); it != _send_queue.end() && cnt < kMaxIov; ++it, ++cnt) {
+                size_t offset = cnt == 0 ? _send_offset : 0;
+                iov[cnt].iov_base = (*it)->data() + offset;
+                iov[cnt].iov_len = (*it)->size() - offset;
+            }
+
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            ssize_t n = ::sendmsg(_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                shutdown(SockException(Err_reset, strerror(errno)));
+                return;
+            }
+
+            // 移除已完整发送的Buffer
+            size_t sent = n;
+            _send_bytes -= sent;
+            while (sent > 0) {
+                size_t remain = _send_queue.front()->size() - _send_offset;
+                if (sent < remain) {
+                    _send_offset += sent;
+                    break;
+                }
+                sent -= remain;
+                _send_offset = 0;
+                _send_queue.pop_front();
+            }
+        }
+
+        // 内核缓冲满时才监听写事件，写完后取消
+        bool pending = !_send_queue.empty();
+        if (_fd >= 0 && pending != _write_pending) {
+            _write_pending = pending;
+            int event = EventPoller::Event_Read | EventPoller::Event_Error;
+            if (pending) event |= EventPoller::Event_Write;
+            _poller->modifyEvent(_fd, event);
+        }
+    }
+
+private:
+    EventPoller::Ptr _poller;
+    int _fd = -1;
+    bool _write_pending = false;
+    size_t _send_offset = 0;
+    size_t _send_bytes = 0;
+    std::deque<Buffer::Ptr> _send_queue;
+    std::function<void(TcpSession*)> _on_detach;
+};
+
+/**
+ * TCP服务器（参考ZLToolKit的TcpServer）
+ * 在一个EventPoller上accept，并通过工厂函数创建会话
+ * 默认会话与服务器在同一个loop上，便于分发时无锁遍历；
+ * 开启setMultiPoller后会话分散到EventPollerPool的各个loop，会话的回调和send在各自的loop上执行
+ */
+class TcpServer : public std::enable_shared_from_this<TcpServer> {
+public:
+    using Ptr = std::shared_ptr<TcpServer>;
+    using SessionCreator = std::function<TcpSession::Ptr(const EventPoller::Ptr&, int fd)>;
+    using SessionMap = std::unordered_map<TcpSession*, TcpSession::Ptr>;
+
+    explicit TcpServer(const EventPoller::Ptr& poller = nullptr)
+        : _poller(poller ? poller : EventPollerPool::Instance().getPoller(false)) {}
+
+    virtual ~TcpServer() {
+        stop();
+    }
+
+    /**
+     * 开始监听
+     * @param port 监听端口，0表示随机端口
+     * @param creator 会话工厂
+     * @param local_ip 绑定的本地IP
+     * @return 是否成功
+     */
+    bool start(uint16_t port, SessionCreator creator, const std::string& local_ip = "0.0.0.0") {
+        stop();
+        _listen_fd = SockUtil::listen(port, local_ip.c_str());
+        if (_listen_fd < 0) {
+            return false;
+        }
+        _creator = std::move(creator);
+
+        std::weak_ptr<TcpServer> weak_self = shared_from_this();
+        _poller->addEvent(_listen_fd, EventPoller::Event_Read, [weak_self](int) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onAccept();
+            }
+        });
+        return true;
+    }
+
+    void stop() {
+        if (_listen_fd < 0) return;
+        int fd = _listen_fd;
+        _listen_fd = -1;
+        auto sessions = _sessions;
+        _poller->delEvent(fd);
+        _poller->async([fd, sessions]() {
+            ::close(fd);
+            std::unordered_map<TcpSession*, TcpSession::Ptr> copy;
+            copy.swap(*sessions);
+            // 会话只能在自己的loop上关闭，引用移入任务，使析构也发生在那里
+            for (auto& pr : copy) {
+                auto poller = pr.second->getPoller();
+                poller->async([session = std::move(pr.second)]() {
+                    session->setOnDetach(nullptr);
+                    session->shutdown();
+                });
+            }
+        });
+    }
+
+    uint16_t getPort() const {
+        return _listen_fd >= 0 ? SockUtil::getLocalPort(_listen_fd) : 0;
+    }
+
+    /**
+     * 把accept到的会话分配到EventPollerPool中负载最小的loop（与TcpClient相同，
+     * 开启steer_by_incoming_cpu时按SO_INCOMING_CPU选择），必须在start之前调用，默认关闭
+     */
+    void setMultiPoller(bool enable) { _multi_poller = enable; }
+
+    const EventPoller::Ptr& getPoller() const { return _poller; }
+
+    /**
+     * 当前会话数，必须在poller线程调用（会话分散到其他loop时，关闭后从这里移除有一次投递的延迟）
+     */
+    size_t sessionCount() const { return _sessions->size(); }
+
+private:
+    void onAccept() {
+        while (_listen_fd >= 0) {
+            int fd = ::accept(_listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            SockUtil::setNoBlocked(fd);
+            SockUtil::setNoDelay(fd);
+            SockUtil::setCloExec(fd);
+
+            auto poller = _multi_poller ? EventPollerPool::Instance().getPollerForSock(fd, false) : _poller;
+            auto session = _creator(poller, fd);
+            if (!session) {
+                ::close(fd);
+                continue;
+            }
+            // 会话在自己的loop上断开，会话表只在服务器loop访问；
+            // 移除后把引用送回会话的loop释放，会话（及其发送节拍队列）不在其他线程析构
+            std::weak_ptr<SessionMap> weak_sessions = _sessions;
+            EventPoller::Ptr server_poller = _poller;
+            session->setOnDetach([weak_sessions, server_poller](TcpSession* ptr) {
+                server_poller->async([weak_sessions, ptr]() {
+                    auto sessions = weak_sessions.lock();
+                    if (!sessions) return;
+                    auto it = sessions->find(ptr);
+                    if (it == sessions->end()) return;
+                    auto session = std::move(it->second);
+                    sessions->erase(it);
+                    auto poller = session->getPoller();
+                    poller->async([session = std::move(session)]() {});
+                });
+            });
+            _sessions->emplace(session.get(), session);
+            session->attachEvent();
+        }
+    }
+
+private:
+    EventPoller::Ptr _poller;
+    int _listen_fd = -1;
+    bool _multi_poller = false;
+    SessionCreator _creator;
+    // 只在poller线程访问
+    std::shared_ptr<SessionMap> _sessions = std::make_shared<SessionMap>();
+};
+
+} // namespace toolkit
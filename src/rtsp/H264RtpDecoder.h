@@ -0,0 +1,304 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include "rtsp/RtpPacket.h"
+
+/**
+ * H264帧，数据为AVCC格式（每个NALU前加4字节大端长度）
+ * SPS/PPS/AUD不放在帧数据里，由解包器单独保存
+ */
+struct H264Frame {
+    using Ptr = std::shared_ptr<H264Frame>;
+
+    uint32_t timestamp = 0;  // RTP时间戳(90kHz)
+    bool key = false;        // 是否包含IDR
+    std::string data;        // AVCC数据
+};
+
+/**
+ * H264 RTP解包（RFC 6184），支持单NALU、STAP-A、FU-A
+ * 按marker位或时间戳变化切分帧
+ */
+class H264RtpDecoder {
+public:
+    using Ptr = std::shared_ptr<H264RtpDecoder>;
+    using onFrame = std::function<void(const H264Frame::Ptr&)>;
+
+    void setOnFrame(onFrame cb) { _on_frame = std::move(cb); }
+
+    /**
+     * 从SDP提取H264的payload type和sprop-parameter-sets中的SPS/PPS
+     */
+    void setSdp(const std::string& sdp) {
+        size_t pos = sdp.find(" H264/");
+        if (pos != std::string::npos) {
+            size_t start = sdp.rfind("a=rtpmap:", pos);
+            if (start != std::string::npos) _pt = atoi(sdp.c_str() + start + 9);
+        }
+
+        pos = sdp.find("sprop-parameter-sets=");
+        if (pos == std::string::npos) return;
+        pos += 21;
+        size_t end = sdp.find_first_of(";\r\n", pos);
+        std::string sets = sdp.substr(pos, end - pos);
+
+        size_t comma = sets.find(',');
+        std::string sps = decodeBase64(sets.substr(0, comma));
+        std::string pps = comma != std::string::npos ? decodeBase64(sets.substr(comma + 1)) : "";
+        if (!sps.empty()) _sps = sps;
+        if (!pps.empty()) _pps = pps;
+    }
+
+    void input(const RtpPacket::Ptr& pkt) {
+        const std::string& payload = pkt->payload;
+        if (payload.empty()) return;
+        if (_pt >= 0 && pkt->pt != _pt) return;  // 其他轨道或RTCP
+
+        if (_frame && pkt->timestamp != _frame->timestamp) {
+            flushFrame();
+        }
+        if (_have_seq && (uint16_t)(_last_seq + 1) != pkt->seq) {
+            // 丢包，丢弃未完成的分片
+            _fu_buffer.clear();
+        }
+        _have_seq = true;
+        _last_seq = pkt->seq;
+
+        const char* data = payload.data();
+        size_t len = payload.size();
+        uint8_t nal_type = (uint8_t)data[0] & 0x1F;
+
+        if (nal_type >= 1 && nal_type <= 23) {
+            onNalu(pkt->timestamp, data, len);
+        } else if (nal_type == 24) {
+            // STAP-A: [hdr][size16][nalu][size16][nalu]...
+            size_t off = 1;
+            while (off + 2 <= len) {
+                size_t nalu_len = ((uint8_t)data[off] << 8) | (uint8_t)data[off + 1];
+                off += 2;
+                if (off + nalu_len > len) break;
+                onNalu(pkt->timestamp, data + off, nalu_len);
+                off += nalu_len;
+            }
+        } else if (nal_type == 28 && len > 2) {
+            // FU-A: [indicator][header][payload]
+            uint8_t fu_header = (uint8_t)data[1];
+            bool start = (fu_header & 0x80) != 0;
+            bool end = (fu_header & 0x40) != 0;
+            if (start) {
+                _fu_buffer.assign(1, (char)(((uint8_t)data[0] & 0xE0) | (fu_header & 0x1F)));
+            } else if (_fu_buffer.empty()) {
+                // 起始分片丢失
+                return;
+            }
+            _fu_buffer.append(data + 2, len - 2);
+            if (end) {
+                onNalu(pkt->timestamp, _fu_buffer.data(), _fu_buffer.size());
+                _fu_buffer.clear();
+            }
+        }
+
+        if (pkt->marker) {
+            flushFrame();
+        }
+    }
+
+    const std::string& getSps() const { return _sps; }
+    const std::string& getPps() const { return _pps; }
+    bool ready() const { return !_sps.empty() && !_pps.empty(); }
+
+    /**
+     * 生成AVCDecoderConfigurationRecord（FLV/MP4的avcC）
+     */
+    std::string getAvcConfig() const {
+        if (!ready() || _sps.size() < 4) return "";
+        std::string cfg;
+        cfg.push_back(0x01);
+        cfg.push_back(_sps[1]);  // profile
+        cfg.push_back(_sps[2]);  // compatibility
+        cfg.push_back(_sps[3]);  // level
+        cfg.push_back((char)0xFF);  // 4字节NALU长度
+        cfg.push_back((char)0xE1);  // 1个SPS
+        cfg.push_back((char)(_sps.size() >> 8));
+        cfg.push_back((char)(_sps.size() & 0xFF));
+        cfg.append(_sps);
+        cfg.push_back(0x01);  // 1个PPS
+        cfg.push_back((char)(_pps.size() >> 8));
+        cfg.push_back((char)(_pps.size() & 0xFF));
+        cfg.append(_pps);
+        return cfg;
+    }
+
+    /**
+     * 从SPS解析分辨率，失败返回false
+     */
+    bool getResolution(int& width, int& height) const {
+        return parseSpsResolution(_sps, width, height);
+    }
+
+private:
+    void onNalu(uint32_t timestamp, const char* data, size_t len) {
+        if (len == 0) return;
+        uint8_t type = (uint8_t)data[0] & 0x1F;
+        switch (type) {
+            case 7: _sps.assign(data, len); return;
+            case 8: _pps.assign(data, len); return;
+            case 9: return;  // AUD
+            default: break;
+        }
+
+        if (!_frame) {
+            _frame = std::make_shared<H264Frame>();
+            _frame->timestamp = timestamp;
+        }
+        if (type == 5) _frame->key = true;
+
+        uint32_t n = (uint32_t)len;
+        char hdr[4] = {(char)(n >> 24), (char)(n >> 16), (char)(n >> 8), (char)n};
+        _frame->data.append(hdr, 4);
+        _frame->data.append(data, len);
+    }
+
+    void flushFrame() {
+        if (!_frame) return;
+        auto frame = std::move(_frame);
+        _frame = nullptr;
+        if (_on_frame && !frame->data.empty()) _on_frame(frame);
+    }
+
+    static std::string decodeBase64(const std::string& in) {
+        static const std::string chars =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        uint32_t val = 0;
+        int bits = -8;
+        for (char c : in) {
+            size_t idx = chars.find(c);
+            if (idx == std::string::npos) break;  // '='或非法字符
+            val = (val << 6) | (uint32_t)idx;
+            bits += 6;
+            if (bits >= 0) {
+                out.push_back((char)((val >> bits) & 0xFF));
+                bits -= 8;
+            }
+        }
+        return out;
+    }
+
+    /**
+     * 指数哥伦布码读取器，自动跳过防竞争字节
+     */
+    class BitReader {
+    public:
+        BitReader(const std::string& nalu) {
+            for (size_t i = 0; i < nalu.size(); ++i) {
+                if (i >= 2 && nalu[i] == 0x03 && nalu[i - 1] == 0 && nalu[i - 2] == 0) continue;
+                _data.push_back((uint8_t)nalu[i]);
+            }
+        }
+        uint32_t bits(int n) {
+            uint32_t v = 0;
+            while (n-- > 0) {
+                if (_pos >= _data.size() * 8) { _error = true; return 0; }
+                v = (v << 1) | ((_data[_pos / 8] >> (7 - _pos % 8)) & 1);
+                ++_pos;
+            }
+            return v;
+        }
+        uint32_t ue() {
+            int zeros = 0;
+            while (!_error && bits(1) == 0 && zeros < 31) ++zeros;
+            return ((1u << zeros) - 1) + bits(zeros);
+        }
+        int32_t se() {
+            uint32_t v = ue();
+            return (v & 1) ? (int32_t)((v + 1) / 2) : -(int32_t)(v / 2);
+        }
+        void skip(int n) { bits(n); }
+        bool error() const { return _error; }
+    private:
+        std::vector<uint8_t> _data;
+        size_t _pos = 0;
+        bool _error = false;
+    };
+
+    static bool parseSpsResolution(const std::string& sps, int& width, int& height) {
+        if (sps.size() < 4) return false;
+        BitReader br(sps);
+        br.skip(8);  // nal header
+        uint32_t profile_idc = br.bits(8);
+        br.skip(16);  // constraint flags + level
+        br.ue();      // sps id
+
+        uint32_t chroma_format_idc = 1;
+        if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 || profile_idc == 244 ||
+            profile_idc == 44 || profile_idc == 83 || profile_idc == 86 || profile_idc == 118 ||
+            profile_idc == 128 || profile_idc == 138 || profile_idc == 139 || profile_idc == 134) {
+            chroma_format_idc = br.ue();
+            if (chroma_format_idc == 3) br.skip(1);
+            br.ue();      // bit_depth_luma
+            br.ue();      // bit_depth_chroma
+            br.skip(1);   // qpprime_y_zero_transform_bypass
+            if (br.bits(1)) {  // seq_scaling_matrix_present
+                int count = chroma_format_idc != 3 ? 8 : 12;
+                for (int i = 0; i < count; ++i) {
+                    if (!br.bits(1)) continue;
+                    int size = i < 6 ? 16 : 64;
+                    int last = 8, next = 8;
+                    for (int j = 0; j < size; ++j) {
+                        if (next != 0) next = (last + br.se() + 256) % 256;
+                        last = next == 0 ? last : next;
+                    }
+                }
+            }
+        }
+
+        br.ue();  // log2_max_frame_num
+        uint32_t poc_type = br.ue();
+        if (poc_type == 0) {
+            br.ue();
+        } else if (poc_type == 1) {
+            br.skip(1);
+            br.se();
+            br.se();
+            uint32_t n = br.ue();
+            for (uint32_t i = 0; i < n && !br.error(); ++i) br.se();
+        }
+        br.ue();      // max_num_ref_frames
+        br.skip(1);   // gaps_in_frame_num_allowed
+        uint32_t width_mbs = br.ue() + 1;
+        uint32_t height_map_units = br.ue() + 1;
+        uint32_t frame_mbs_only = br.bits(1);
+        if (!frame_mbs_only) br.skip(1);
+        br.skip(1);   // direct_8x8_inference
+
+        uint32_t crop_l = 0, crop_r = 0, crop_t = 0, crop_b = 0;
+        if (br.bits(1)) {
+            crop_l = br.ue();
+            crop_r = br.ue();
+            crop_t = br.ue();
+            crop_b = br.ue();
+        }
+        if (br.error()) return false;
+
+        uint32_t crop_x = chroma_format_idc == 0 ? 1 : (chroma_format_idc == 3 ? 1 : 2);
+        uint32_t crop_y = (chroma_format_idc == 1 ? 2 : 1) * (2 - frame_mbs_only);
+        width = (int)(width_mbs * 16 - (crop_l + crop_r) * crop_x);
+        height = (int)((2 - frame_mbs_only) * height_map_units * 16 - (crop_t + crop_b) * crop_y);
+        return width > 0 && height > 0;
+    }
+
+private:
+    std::string _sps;
+    std::string _pps;
+    std::string _fu_buffer;
+    H264Frame::Ptr _frame;
+    bool _have_seq = false;
+    uint16_t _last_seq = 0;
+    int _pt = -1;
+    onFrame _on_frame;
+};
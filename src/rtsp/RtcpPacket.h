@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// RTCP Sender Report (RFC 3550 6.4.1)
+struct RtcpSenderReport {
+    uint32_t ssrc = 0;
+    uint32_t ntp_sec = 0;       // NTP时间戳整数部分（1900年起）
+    uint32_t ntp_frac = 0;      // NTP时间戳小数部分
+    uint32_t rtp_timestamp = 0; // 与NTP时间对应的RTP时间戳
+    uint32_t packet_count = 0;
+    uint32_t octet_count = 0;
+
+    // 转换为unix时间(us)
+    int64_t unixUs() const {
+        static constexpr int64_t kNtpUnixOffset = 2208988800LL;
+        return ((int64_t)ntp_sec - kNtpUnixOffset) * 1000000 + (int64_t)(((uint64_t)ntp_frac * 1000000) >> 32);
+    }
+};
+
+class RtcpPacket {
+public:
+    /**
+     * 解析复合RTCP包，每个SR回调一次，其他类型跳过
+     * @return 是否为合法的RTCP包
+     */
+    static bool parse(const char* data, size_t len, const std::function<void(const RtcpSenderReport&)>& on_sr) {
+        const uint8_t* p = (const uint8_t*)data;
+        bool valid = false;
+        while (len >= 4) {
+            uint8_t version = p[0] >> 6;
+            uint8_t pt = p[1];
+            size_t pkt_len = (((size_t)p[2] << 8) | p[3]) * 4 + 4;
+            if (version != 2 || pt < 192 || pt > 223 || pkt_len > len) break;
+            valid = true;
+
+            // SR: 头部4字节 + SSRC 4字节 + 发送者信息20字节
+            if (pt == kSenderReport && pkt_len >= 28 && on_sr) {
+                RtcpSenderReport sr;
+                sr.ssrc = readU32(p + 4);
+                sr.ntp_sec = readU32(p + 8);
+                sr.ntp_frac = readU32(p + 12);
+                sr.rtp_timestamp = readU32(p + 16);
+                sr.packet_count = readU32(p + 20);
+                sr.octet_count = readU32(p + 24);
+                on_sr(sr);
+            }
+            p += pkt_len;
+            len -= pkt_len;
+        }
+        return valid;
+    }
+
+private:
+    static constexpr uint8_t kSenderReport = 200;
+
+    static uint32_t readU32(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+};
+
+/**
+ * 根据最近一次SR把RTP时间戳映射为发送端的wall clock时间
+ */
+class RtpNtpMapper {
+public:
+    void setClockRate(uint32_t clock_rate) { _clock_rate = clock_rate ? clock_rate : 90000; }
+
+    void onSenderReport(const RtcpSenderReport& sr) {
+        _rtp_timestamp = sr.rtp_timestamp;
+        _ntp_us = sr.unixUs();
+        _valid = true;
+    }
+
+    bool valid() const { return _valid; }
+
+    /**
+     * RTP时间戳对应的发送端unix时间(us)，按有符号差值处理32位回绕
+     */
+    int64_t toUnixUs(uint32_t rtp_timestamp) const {
+        int32_t diff = (int32_t)(rtp_timestamp - _rtp_timestamp);
+        return _ntp_us + (int64_t)diff * 1000000 / _clock_rate;
+    }
+
+private:
+    bool _valid = false;
+    uint32_t _clock_rate = 90000;
+    uint32_t _rtp_timestamp = 0;
+    int64_t _ntp_us = 0;
+};
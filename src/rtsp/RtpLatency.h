@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "rtsp/RtpPacket.h"
+#include "util/LatencyHistogram.h"
+
+/**
+ * 单路流的延时统计，按阶段拆分：
+ * network  发送端采集(RTCP SR映射) -> 内核收包，依赖两端时钟同步
+ * library  内核收包 -> 写入RingBuffer（拆包、解析，同一次socket读的包整批写入）
+ * dispatch RingBuffer分发给所有读者回调的耗时（按批计），异步读者在这里只包含拷贝入队
+ * async    异步读者从入队到回调返回，含strand排队等待（每个异步读者每包一次）
+ */
+class RtpLatencyStats {
+public:
+    using Ptr = std::shared_ptr<RtpLatencyStats>;
+
+    /**
+     * 记录一个已分发完成的包
+     * @param done_ns 所有读者回调返回的时间
+     */
+    void record(const RtpPacket& pkt, int64_t done_ns) {
+        const auto& st = pkt.stamps;
+        if (st.capture && st.kernel) network.record((st.kernel - st.capture) / 1000);
+        int64_t start = st.kernel ? st.kernel : st.splitter;
+        if (start && st.ring) library.record((st.ring - start) / 1000);
+        if (st.ring) dispatch.record((done_ns - st.ring) / 1000);
+    }
+
+    /**
+     * 记录一次异步读者回调，在worker线程调用，见RingBuffer::setAsyncObserver
+     */
+    void recordAsync(int64_t delay_us) { async.record(delay_us); }
+
+    void reset() {
+        network.reset();
+        library.reset();
+        dispatch.reset();
+        async.reset();
+    }
+
+    std::string toString() const {
+        return "network: " + network.toString() + "\nlibrary: " + library.toString() +
+               "\ndispatch: " + dispatch.toString() + "\nasync: " + async.toString();
+    }
+
+    toolkit::LatencyHistogram network;
+    toolkit::LatencyHistogram library;
+    toolkit::LatencyHistogram dispatch;
+    toolkit::LatencyHistogram async;
+};
@@ -18,6 +18,15 @@ struct RtpPacket {
     uint32_t ssrc = 0;       // SSRC
     std::string payload;     // RTP Payload
 
+    // 各阶段时间（unix时间，ns），开启延时统计后有效，0表示未知
+    struct Stamps {
+        int64_t capture = 0;   // 发送端采集时间，由RTCP SR映射
+        int64_t kernel = 0;    // 内核收包时间(SO_TIMESTAMPING)
+        int64_t splitter = 0;  // 从TCP流中拆出
+        int64_t parse = 0;     // RTP头解析完成
+        int64_t ring = 0;      // 写入RingBuffer
+    } stamps;
+
     static Ptr parse(const char* data, size_t len) {
         if (len < 12) return nullptr;
 
@@ -66,6 +75,46 @@ struct RtpPacket {
             return start_bit && fu_type == 5;
         }
 
+        // STAP-A中含IDR
+        if (nalu_type == 24) return (stapTypes() & (1u << 5)) != 0;
+
         return false;
     }
+
+    /**
+     * 是否为帧前的非VCL包：SEI/SPS/PPS，或不含IDR的STAP-A
+     * 关键帧的访问单元从它之前同一时间戳的这些包开始
+     */
+    bool isParameterSet() const {
+        if (payload.empty()) return false;
+        uint8_t nalu_type = (uint8_t)payload[0] & 0x1F;
+        if (nalu_type == 6 || nalu_type == 7 || nalu_type == 8) return true;
+        return nalu_type == 24 && (stapTypes() & (1u << 5)) == 0;
+    }
+
+    /**
+     * 是否为关键帧访问单元的起点：SPS、含SPS的STAP-A或IDR起始包
+     * 按读批次抽帧时SPS/PPS可能与IDR分在两批，帧起点需据此判断为关键帧
+     */
+    bool isKeyFrameStart() const {
+        if (payload.empty()) return false;
+        uint8_t nalu_type = (uint8_t)payload[0] & 0x1F;
+        if (nalu_type == 7) return true;
+        if (nalu_type == 24 && (stapTypes() & (1u << 7))) return true;
+        return isKeyFrame();
+    }
+
+private:
+    // STAP-A中各NALU类型的位掩码
+    uint32_t stapTypes() const {
+        uint32_t types = 0;
+        size_t pos = 1;
+        while (pos + 2 < payload.size()) {
+            size_t len = ((uint8_t)payload[pos] << 8) | (uint8_t)payload[pos + 1];
+            if (len == 0 || pos + 2 + len > payload.size()) break;
+            types |= 1u << ((uint8_t)payload[pos + 2] & 0x1F);
+            pos += 2 + len;
+        }
+        return types;
+    }
 };
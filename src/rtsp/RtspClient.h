@@ -2,10 +2,17 @@
 #include "network/TcpClient.h"
 #include "rtsp/RtspSplitter.h"
 #include "rtsp/RtpPacket.h"
+#include "rtsp/RtcpPacket.h"
+#include "rtsp/RtpLatency.h"
 #include "util/RingBuffer.h"
+#include "util/Logger.h"
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <strings.h>
 #include <openssl/md5.h>
 
 using namespace toolkit;
@@ -17,35 +24,105 @@ public:
 
     RtspClient() {
         _ring = std::make_shared<RingType>();
+        _latency = std::make_shared<RtpLatencyStats>();
     }
 
+    ~RtspClient() override {
+        cancelTimers();
+    }
+
+    /**
+     * 开始拉流，失败后可以再次调用重新开始
+     */
     void play(const std::string& url) {
         parseUrl(url);
+        resetSession();
         _splitter.setOnResponse([this](const std::string& r) { onRtspResponse(r); });
         _splitter.setOnRtp([this](const char* d, size_t l, int t) { onRtpPacket(d, l, t); });
         startConnect(_host, _port);
     }
 
     RingType::Ptr getRing() { return _ring; }
+
+    /**
+     * DESCRIBE返回的SDP，PLAY成功后有效，重连时会更新
+     */
+    std::string getSdp() const {
+        std::lock_guard<std::mutex> lock(_sdp_mutex);
+        return _sdp;
+    }
     void setOnPlayResult(std::function<void(bool, const std::string&)> cb) { _on_result = cb; }
 
+    /**
+     * 设置超时，必须在play之前调用
+     * @param request_ms RTSP请求超时（毫秒），服务器不回复时断开
+     * @param rtp_ms 播放后收不到RTP的断流超时（毫秒），0表示不检测
+     */
+    void setTimeout(uint64_t request_ms, uint64_t rtp_ms) {
+        _request_timeout_ms = request_ms;
+        _rtp_timeout_ms = rtp_ms;
+    }
+
+    /**
+     * 断线重连，间隔从min_delay_ms开始指数退避到max_delay_ms，播放成功后重置
+     * 必须在play之前调用
+     */
+    void setReconnect(bool enable, uint64_t min_delay_ms = 1000, uint64_t max_delay_ms = 30000) {
+        _reconnect = enable;
+        _reconnect_min_ms = min_delay_ms ? min_delay_ms : 1;
+        _reconnect_max_ms = std::max(max_delay_ms, _reconnect_min_ms);
+    }
+
+    /**
+     * 开启延时统计（内核收包时间戳、各阶段时间、RTCP SR时钟映射），必须在play和attachAsync之前调用
+     */
+    void enableLatencyStats(bool enable = true) {
+        _latency_enabled = enable;
+        setRecvTimestamp(enable);
+        auto latency = _latency;
+        _ring->setAsyncObserver(enable ? [latency](int64_t delay_us) { latency->recordAsync(delay_us); }
+                                       : std::function<void(int64_t)>());
+    }
+
+    /**
+     * 延时直方图，可在任意线程读取
+     */
+    RtpLatencyStats::Ptr getLatencyStats() const { return _latency; }
+
+    /**
+     * 停止播放并取消重连
+     */
+    void stop() {
+        _reconnect = false;
+        if (auto poller = getPoller()) {
+            poller->sync([this]() { cancelTimers(); });
+        }
+        shutdown();
+    }
+
 protected:
     void onConnect(const SockException& ex) override {
         if (ex) {
-            fprintf(stderr, "Connect failed: %s\n", ex.what());
-            if (_on_result) _on_result(false, ex.what());
+            WarnLimit(_log_limiter, "%s connect failed: %s", _url.c_str(), ex.what());
+            onFailed(ex.what());
             return;
         }
-        fprintf(stderr, "Connected to %s:%d\n", _host.c_str(), _port);
+        InfoL("%s connected to %s:%d", _url.c_str(), _host.c_str(), _port);
+        if (isTls()) {
+            InfoL("%s tls session %s, kernel tls recv %s", _url.c_str(), tlsSessionReused() ? "resumed" : "new",
+                  tlsKernelRecv() ? "on" : "off");
+        }
         sendOptions();
     }
 
     void onRecv(const Buffer::Ptr& buf) override {
         _splitter.input(buf->data(), buf->size());
+        flushBatch();
     }
 
     void onError(const SockException& ex) override {
-        if (_on_result) _on_result(false, ex.what());
+        WarnLimit(_log_limiter, "%s connection lost: %s", _url.c_str(), ex.what());
+        onFailed(ex.what());
     }
 
 private:
@@ -76,7 +153,10 @@ private:
 
         pos = host_port.find(':');
         _host = (pos != std::string::npos) ? host_port.substr(0, pos) : host_port;
-        _port = (pos != std::string::npos) ? std::stoi(host_port.substr(pos + 1)) : 554;
+        // rtsps默认端口322（RFC 7826）
+        bool tls = strcasecmp(schema.c_str(), "rtsps") == 0;
+        _port = (pos != std::string::npos) ? std::stoi(host_port.substr(pos + 1)) : (tls ? 322 : 554);
+        setTls(tls);
 
         _play_url = schema + "://" + host_port + path;
     }
@@ -149,8 +229,20 @@ private:
         ss << "\r\n";
 
         std::string req = ss.str();
-        fprintf(stderr, ">>> SEND (%zu bytes):\n%s\n", req.size(), escapeString(req).c_str());
+        DebugL(">>> SEND (%zu bytes):\n%s", req.size(), escapeString(req).c_str());
         send(req);
+
+        // 请求超时，收到回复时取消
+        if (_request_timer) _request_timer->cancel();
+        auto weak_self = weakSelf();
+        _request_timer = getPoller()->doDelayTask(_request_timeout_ms, [weak_self, method]() -> uint64_t {
+            if (auto strong_self = weak_self.lock()) {
+                WarnLimit(strong_self->_log_limiter, "%s RTSP %s timeout", strong_self->_url.c_str(), method.c_str());
+                strong_self->_request_timer = nullptr;
+                strong_self->onFailed("RTSP " + method + " timeout");
+            }
+            return 0;
+        });
     }
 
     void sendOptions()  { _state = OPTIONS;  sendRequest("OPTIONS", _play_url); }
@@ -158,12 +250,27 @@ private:
     void sendSetup()    { _state = SETUP;    sendRequest("SETUP", _control, {{"Transport", "RTP/AVP/TCP;unicast;interleaved=0-1"}}); }
     void sendPlay()     { _state = PLAY;     sendRequest("PLAY", _play_url, {{"Range", "npt=0.000-"}}); }
 
+    // 保活请求，服务器在OPTIONS的Public中声明支持GET_PARAMETER时优先使用
+    void sendKeepAlive() {
+        sendRequest(_support_get_parameter ? "GET_PARAMETER" : "OPTIONS", _play_url);
+    }
+
     void onRtspResponse(const std::string& resp) {
-        fprintf(stderr, "<<< RECV (%zu bytes):\n%s\n", resp.size(), escapeString(resp).c_str());
+        DebugL("<<< RECV (%zu bytes):\n%s", resp.size(), escapeString(resp).c_str());
 
         int status = 0;
         sscanf(resp.c_str(), "RTSP/1.0 %d", &status);
 
+        if (_request_timer) {
+            _request_timer->cancel();
+            _request_timer = nullptr;
+        }
+        if (_state == PLAYING) {
+            // 保活回复，不驱动状态机
+            if (status != 200) WarnLimit(_log_limiter, "%s keepalive failed: RTSP %d", _url.c_str(), status);
+            return;
+        }
+
         std::string auth_info;
         size_t pos = resp.find("WWW-Authenticate:");
         if (pos != std::string::npos) {
@@ -178,17 +285,16 @@ private:
                     case DESCRIBE: sendDescribe(); break;
                     case SETUP:    sendSetup();    break;
                     case PLAY:     sendPlay();     break;
+                    default: break;
                 }
                 return;
             }
-            if (_on_result) _on_result(false, "Auth failed");
-            shutdown();
+            onFailed("Auth failed");
             return;
         }
 
         if (status != 200) {
-            if (_on_result) _on_result(false, "RTSP " + std::to_string(status));
-            shutdown();
+            onFailed("RTSP " + std::to_string(status));
             return;
         }
 
@@ -198,23 +304,135 @@ private:
             while (start < resp.size() && resp[start] == ' ') start++;
             size_t end = resp.find_first_of(";\r\n", start);
             _session = resp.substr(start, end - start);
+
+            // Session: <id>;timeout=<秒>
+            size_t line_end = resp.find("\r\n", start);
+            size_t timeout_pos = resp.find("timeout=", start);
+            if (timeout_pos != std::string::npos && timeout_pos < line_end) {
+                int timeout = atoi(resp.c_str() + timeout_pos + 8);
+                if (timeout > 0) _session_timeout = timeout;
+            }
         }
 
         switch (_state) {
-            case OPTIONS:  sendDescribe(); break;
+            case OPTIONS:
+                pos = resp.find("Public:");
+                if (pos != std::string::npos) {
+                    size_t end = resp.find("\r\n", pos);
+                    _support_get_parameter = resp.substr(pos, end - pos).find("GET_PARAMETER") != std::string::npos;
+                }
+                sendDescribe();
+                break;
             case DESCRIBE:
+                pos = resp.find("\r\n\r\n");
+                {
+                    std::lock_guard<std::mutex> lock(_sdp_mutex);
+                    _sdp = (pos != std::string::npos) ? resp.substr(pos + 4) : "";
+                }
                 parseSdp(resp);
-                fprintf(stderr, "Control URL: %s\n", _control.c_str());
+                DebugL("Control URL: %s", _control.c_str());
                 sendSetup();
                 break;
             case SETUP:    sendPlay(); break;
             case PLAY:
+                _state = PLAYING;
                 _splitter.enableRtp(true);
+                _reconnect_delay = 0;
+                startKeepAlive();
+                startRtpWatchdog();
                 if (_on_result) _on_result(true, "OK");
                 break;
+            default:
+                break;
+        }
+    }
+
+    std::weak_ptr<RtspClient> weakSelf() {
+        return std::static_pointer_cast<RtspClient>(shared_from_this());
+    }
+
+    // 每隔会话超时的一半发送一次保活
+    void startKeepAlive() {
+        uint64_t interval = (uint64_t)std::max(_session_timeout, 2) * 1000 / 2;
+        auto weak_self = weakSelf();
+        _keepalive_timer = getPoller()->doDelayTask(interval, [weak_self, interval]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self || strong_self->_state != PLAYING) return 0;
+            strong_self->sendKeepAlive();
+            return interval;
+        });
+    }
+
+    // 每个周期检查RTP计数，一个完整周期内没有收到RTP视为断流
+    void startRtpWatchdog() {
+        if (!_rtp_timeout_ms) return;
+        _rtp_count_checked = _rtp_count;
+        auto weak_self = weakSelf();
+        _rtp_timer = getPoller()->doDelayTask(_rtp_timeout_ms, [weak_self]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) return 0;
+            if (strong_self->_rtp_count == strong_self->_rtp_count_checked) {
+                strong_self->_rtp_timer = nullptr;
+                strong_self->onFailed("RTP timeout");
+                return 0;
+            }
+            strong_self->_rtp_count_checked = strong_self->_rtp_count;
+            return strong_self->_rtp_timeout_ms;
+        });
+    }
+
+    void cancelTimers() {
+        for (auto* timer : {&_request_timer, &_keepalive_timer, &_rtp_timer, &_reconnect_timer}) {
+            if (*timer) {
+                (*timer)->cancel();
+                *timer = nullptr;
+            }
         }
     }
 
+    /**
+     * 连接失败、断开、请求超时或断流，在loop线程调用
+     */
+    void onFailed(const std::string& reason) {
+        cancelTimers();
+        shutdown();
+        _state = INIT;
+        if (_on_result) _on_result(false, reason);
+        if (!_reconnect) return;
+
+        uint64_t delay = _reconnect_delay ? _reconnect_delay : _reconnect_min_ms;
+        _reconnect_delay = std::min(delay * 2, _reconnect_max_ms);
+        InfoL("%s reconnect in %llu ms", _url.c_str(), (unsigned long long)delay);
+
+        auto weak_self = weakSelf();
+        _reconnect_timer = getPoller()->doDelayTask(delay, [weak_self]() -> uint64_t {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->_reconnect_timer = nullptr;
+                strong_self->reconnect();
+            }
+            return 0;
+        });
+    }
+
+    void reconnect() {
+        resetSession();
+        startConnect(_host, _port);
+    }
+
+    void resetSession() {
+        _state = INIT;
+        _session.clear();
+        _realm.clear();
+        _nonce.clear();
+        _control.clear();
+        _cseq = 0;
+        _support_get_parameter = false;
+        _session_timeout = 60;
+        _ntp_mapper = RtpNtpMapper();
+        _splitter.reset();
+        _batch.clear();
+    }
+
     void parseSdp(const std::string& resp) {
         std::string base = _play_url;
         size_t pos = resp.find("Content-Base:");
@@ -232,13 +450,22 @@ private:
         }
 
         if (pos != std::string::npos) {
+            // 本媒体段的时钟频率，用于RTCP SR时间映射
+            size_t next = resp.find("m=", pos + 2);
+            size_t map_pos = resp.find("a=rtpmap:", pos);
+            unsigned rate = 0;
+            if (map_pos != std::string::npos && map_pos < next &&
+                sscanf(resp.c_str() + map_pos, "a=rtpmap:%*d %*[^/]/%u", &rate) == 1) {
+                _ntp_mapper.setClockRate(rate);
+            }
+
             size_t ctrl_pos = resp.find("a=control:", pos);
             if (ctrl_pos != std::string::npos) {
                 size_t start = ctrl_pos + 10;
                 size_t end = resp.find_first_of("\r\n", start);
                 std::string ctrl = resp.substr(start, end - start);
 
-                if (ctrl.find("rtsp://") == 0) {
+                if (isAbsoluteUrl(ctrl)) {
                     _control = ctrl;
                 } else if (ctrl == "*") {
                     _control = base;
@@ -259,13 +486,64 @@ private:
         }
     }
 
-    void onRtpPacket(const char* data, size_t len, int track) {
+    // 绝对控制URL，scheme不区分大小写（RFC 7826）
+    static bool isAbsoluteUrl(const std::string& url) {
+        return strncasecmp(url.c_str(), "rtsp://", 7) == 0 || strncasecmp(url.c_str(), "rtsps://", 8) == 0;
+    }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // SETUP使用interleaved=0-1，奇数通道为RTCP
+    void onRtpPacket(const char* data, size_t len, int channel) {
+        if (channel & 1) {
+            RtcpPacket::parse(data, len, [this](const RtcpSenderReport& sr) { _ntp_mapper.onSenderReport(sr); });
+            return;
+        }
+
+        ++_rtp_count;
+        if (!_latency_enabled) {
+            auto pkt = RtpPacket::parse(data, len);
+            if (pkt) _batch.emplace_back(std::move(pkt));
+            return;
+        }
+
+        int64_t splitter_ns = nowNs();
         auto pkt = RtpPacket::parse(data, len);
-        if (pkt) _ring->write(pkt, pkt->isKeyFrame());
+        if (!pkt) return;
+        auto& st = pkt->stamps;
+        st.kernel = getRecvTime();
+        st.splitter = splitter_ns;
+        st.parse = nowNs();
+        if (_ntp_mapper.valid()) st.capture = _ntp_mapper.toUnixUs(pkt->timestamp) * 1000;
+        _batch.emplace_back(std::move(pkt));
+    }
+
+    // 一次socket读解析出的所有包作为一批写入RingBuffer，读者每批只回调一次
+    void flushBatch() {
+        if (_batch.empty()) return;
+        // SPS也算关键帧起点：读批次可能恰好在SPS/PPS之后结束，帧起点不是关键帧时抽帧读者会丢掉整个关键帧
+        auto is_key = [](const RtpPacket::Ptr& pkt) { return pkt->isKeyFrameStart(); };
+        // 同一帧的包RTP时间戳相同，抽帧读者据此按帧过滤
+        auto frame_of = [](const RtpPacket::Ptr& pkt) { return pkt->timestamp; };
+        if (!_latency_enabled) {
+            _ring->writeBatch(_batch.data(), _batch.size(), is_key, frame_of);
+            _batch.clear();
+            return;
+        }
+
+        int64_t ring_ns = nowNs();
+        for (auto& pkt : _batch) pkt->stamps.ring = ring_ns;
+        _ring->writeBatch(_batch.data(), _batch.size(), is_key, frame_of);
+        int64_t done_ns = nowNs();
+        for (auto& pkt : _batch) _latency->record(*pkt, done_ns);
+        _batch.clear();
     }
 
 private:
-    enum State { INIT, OPTIONS, DESCRIBE, SETUP, PLAY } _state = INIT;
+    enum State { INIT, OPTIONS, DESCRIBE, SETUP, PLAY, PLAYING } _state = INIT;
 
     std::string _url;
     std::string _play_url;
@@ -273,11 +551,39 @@ private:
     std::string _password;
     std::string _session;
     std::string _control;
+    std::string _sdp;
+    mutable std::mutex _sdp_mutex;
     std::string _realm;
     std::string _nonce;
     int _cseq = 0;
+    // 重连期间反复出现的同类错误限频输出
+    LogLimiter _log_limiter{10000};
+    int _session_timeout = 60;
+    bool _support_get_parameter = false;
+
+    // 以下定时器都由所属loop的时间轮驱动，只在loop线程访问
+    uint64_t _request_timeout_ms = 10000;
+    uint64_t _rtp_timeout_ms = 10000;
+    uint64_t _rtp_count = 0;
+    uint64_t _rtp_count_checked = 0;
+    EventPoller::DelayTask::Ptr _request_timer;
+    EventPoller::DelayTask::Ptr _keepalive_timer;
+    EventPoller::DelayTask::Ptr _rtp_timer;
+
+    bool _reconnect = false;
+    uint64_t _reconnect_min_ms = 1000;
+    uint64_t _reconnect_max_ms = 30000;
+    uint64_t _reconnect_delay = 0;
+    EventPoller::DelayTask::Ptr _reconnect_timer;
+
+    // 延时统计
+    bool _latency_enabled = false;
+    RtpNtpMapper _ntp_mapper;
+    RtpLatencyStats::Ptr _latency;
 
     RtspSplitter _splitter;
+    // 当前socket读内解析出的RTP包，复用容量避免每次读分配
+    std::vector<RtpPacket::Ptr> _batch;
     RingType::Ptr _ring;
     std::function<void(bool, const std::string&)> _on_result;
 };
@@ -0,0 +1,591 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <netinet/in.h>
+#include "network/TcpServer.h"
+#include "network/Pacer.h"
+#include "rtsp/RtspClient.h"
+#include "rtsp/RtspSplitter.h"
+
+class RtspServerSession;
+
+/**
+ * RTP负载共享Buffer，直接引用RtpPacket的payload，不拷贝
+ */
+class RtpPayloadBuffer : public toolkit::Buffer {
+public:
+    explicit RtpPayloadBuffer(const RtpPacket::Ptr& pkt) : _pkt(pkt) {}
+    char* data() const override { return const_cast<char*>(_pkt->payload.data()); }
+    size_t size() const override { return _pkt->payload.size(); }
+
+private:
+    RtpPacket::Ptr _pkt;
+};
+
+/**
+ * 一路RTSP转发源在一个loop上的分发者，一次拉流分发给该loop上的多个下游客户端
+ * 下游会话分散在多个loop上，每个有下游的loop一个转发源（见RtspServer::findSource）：
+ * RingBuffer写线程每个loop只做一次负载包装、投递一次任务，分发在该loop上进行，
+ * 每个客户端只重写自己的12字节RTP头（seq/ssrc）
+ */
+class RtspRelaySource : public std::enable_shared_from_this<RtspRelaySource>,
+                        public RingReaderBase<RtpPacket::Ptr> {
+public:
+    using Ptr = std::shared_ptr<RtspRelaySource>;
+
+    RtspRelaySource(const toolkit::EventPoller::Ptr& poller, const RtspClient::Ptr& client)
+        : _poller(poller), _client(client) {}
+
+    ~RtspRelaySource() {
+        if (auto ring = _ring.lock()) {
+            ring->detach(_reader_id);
+        }
+    }
+
+    /**
+     * 挂到RtspClient的RingBuffer上（以裸指针挂载的原因见HttpMediaStream::start）
+     */
+    void start() {
+        auto client = _client.lock();
+        if (!client) return;
+        _ring = client->getRing();
+        _reader_id = client->getRing()->attach(this);
+    }
+
+    /**
+     * 下游SDP：上游会话级描述 + 实际拉取的那一路媒体描述，control改为trackID=0
+     * @return 上游尚未DESCRIBE时返回空
+     */
+    std::string getSdp() {
+        auto client = _client.lock();
+        if (!client || client->getSdp().empty()) return "";
+        return rewriteSdp(client->getSdp());
+    }
+
+    /**
+     * 添加播放者，先发送缓存的GOP，必须在本转发源的poller线程（即会话所在loop）调用
+     */
+    void addPlayer(const std::shared_ptr<RtspServerSession>& session);
+
+    size_t playerCount() const { return _players.size(); }
+
+private:
+    struct RelayItem {
+        RtpPacket::Ptr pkt;
+        toolkit::Buffer::Ptr payload;
+        bool key;
+    };
+
+    // RingBuffer写线程，一次socket读的所有包合并为一个poller任务
+    void onBatch(const RingSpan<RtpPacket::Ptr>& batch) override {
+        if (_payload_types.empty()) {
+            // 第一次收到包时上游SDP已就绪，解析媒体payload type
+            if (auto client = _client.lock()) {
+                std::string mline;
+                rewriteSdp(client->getSdp(), &mline);
+                parsePayloadTypes(mline);
+            }
+        }
+
+        std::vector<RelayItem> items;
+        items.reserve(batch.size());
+        for (auto& pkt : batch) {
+            if (!_payload_types.empty() && !_payload_types.count(pkt->pt)) continue;  // RTCP或其他轨道
+            items.push_back({pkt, std::make_shared<RtpPayloadBuffer>(pkt), pkt->isKeyFrame()});
+        }
+        if (items.empty()) return;
+
+        std::weak_ptr<RtspRelaySource> weak_self = weak_from_this();
+        _poller->async([weak_self, items]() {
+            if (auto strong_self = weak_self.lock()) {
+                for (auto& item : items) {
+                    strong_self->dispatch(item.pkt, item.payload, item.key);
+                }
+            }
+        }, false);
+    }
+
+    // poller线程，key为关键帧分片的起始包（isKeyFrame）
+    void dispatch(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload, bool key);
+
+    // poller线程，key表示一个关键帧访问单元的第一个包，GOP缓存从这里开始
+    void forward(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload, bool key);
+
+    static std::string rewriteSdp(const std::string& sdp, std::string* media_line = nullptr) {
+        std::vector<std::string> lines;
+        size_t start = 0;
+        while (start < sdp.size()) {
+            size_t end = sdp.find('\n', start);
+            if (end == std::string::npos) end = sdp.size();
+            std::string line = sdp.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) lines.push_back(line);
+            start = end + 1;
+        }
+
+        // 与RtspClient::parseSdp的选择一致：优先视频，否则音频
+        int media = -1;
+        for (size_t i = 0; i < lines.size() && media < 0; ++i) {
+            if (lines[i].compare(0, 7, "m=video") == 0) media = (int)i;
+        }
+        for (size_t i = 0; i < lines.size() && media < 0; ++i) {
+            if (lines[i].compare(0, 7, "m=audio") == 0) media = (int)i;
+        }
+
+        std::string out;
+        size_t i = 0;
+        for (; i < lines.size() && lines[i].compare(0, 2, "m=") != 0; ++i) {
+            if (lines[i].compare(0, 10, "a=control:") == 0) continue;
+            out += lines[i] + "\r\n";
+        }
+        if (media >= 0) {
+            out += lines[media] + "\r\n";
+            if (media_line) *media_line = lines[media];
+            for (i = media + 1; i < lines.size() && lines[i].compare(0, 2, "m=") != 0; ++i) {
+                if (lines[i].compare(0, 10, "a=control:") == 0) continue;
+                out += lines[i] + "\r\n";
+            }
+            out += "a=control:trackID=0\r\n";
+        }
+        return out;
+    }
+
+    // m=video 0 RTP/AVP 96 97
+    void parsePayloadTypes(const std::string& mline) {
+        std::set<int> pts;
+        size_t pos = mline.find("RTP/AVP");
+        if (pos == std::string::npos) return;
+        pos = mline.find(' ', pos);
+        while (pos != std::string::npos) {
+            pts.insert(atoi(mline.c_str() + pos + 1));
+            pos = mline.find(' ', pos + 1);
+        }
+        _payload_types.swap(pts);
+    }
+
+private:
+    toolkit::EventPoller::Ptr _poller;
+    std::weak_ptr<RtspClient> _client;
+    std::weak_ptr<RtspClient::RingType> _ring;
+    RtspClient::RingType::ReaderId _reader_id = 0;
+
+    // RingBuffer写线程
+    std::set<int> _payload_types;
+
+    // poller线程
+    struct CachedPacket {
+        RtpPacket::Ptr pkt;
+        toolkit::Buffer::Ptr payload;
+    };
+    std::vector<CachedPacket> _gop;
+    // 暂存的SPS/PPS等前导包，等下一个包确定是否属于新关键帧
+    std::vector<CachedPacket> _prefix;
+    bool _have_key = false;
+    uint32_t _key_timestamp = 0;
+    std::vector<std::weak_ptr<RtspServerSession>> _players;
+};
+
+class RtspServer;
+
+/**
+ * 下游RTSP会话，支持RTP over TCP(interleaved)和RTP over UDP
+ */
+class RtspServerSession : public toolkit::TcpSession {
+public:
+    using Ptr = std::shared_ptr<RtspServerSession>;
+
+    // 发送队列超过该值认为是慢消费者，丢包直到下一个关键帧
+    static constexpr size_t kMaxSendQueue = 2 * 1024 * 1024;
+
+    struct PacedRtp {
+        RtpPacket::Ptr pkt;
+        toolkit::Buffer::Ptr payload;
+    };
+
+    /**
+     * 平滑发送配置，关键帧不再一次性写入socket，而是摊到一个帧间隔内发出
+     */
+    struct Pacing {
+        bool enable = false;
+        toolkit::PacedQueue<PacedRtp>::Config queue;
+        // 额外设置SO_MAX_PACING_RATE（字节/秒），由内核在更细粒度上平滑，只对TCP下游生效；0表示不设置
+        uint64_t kernel_max_rate = 0;
+    };
+
+    RtspServerSession(const toolkit::EventPoller::Ptr& poller, int fd,
+                      const std::weak_ptr<RtspServer>& server, const Pacing& pacing)
+        : TcpSession(poller, fd), _server(server) {
+        _splitter.enableRtp(true);  // 客户端可能发送interleaved RTCP
+        _splitter.setOnResponse([this](const std::string& req) { onRequest(req); });
+
+        std::random_device rd;
+        _ssrc = rd();
+        _seq = (uint16_t)rd();
+        char sid[17];
+        snprintf(sid, sizeof(sid), "%08X%08X", rd(), rd());
+        _session_id = sid;
+
+        if (pacing.enable) {
+            // 队列由本会话持有，析构时stop，调度器不会再回调已销毁的会话
+            _pacer = std::make_shared<toolkit::PacedQueue<PacedRtp>>(poller, pacing.queue, [this](const PacedRtp& rtp) {
+                writeRtp(rtp.pkt, rtp.payload);
+            });
+            if (pacing.kernel_max_rate) toolkit::SockUtil::setMaxPacingRate(fd, pacing.kernel_max_rate);
+        }
+    }
+
+    ~RtspServerSession() override {
+        if (_pacer) _pacer->stop();
+    }
+
+    /**
+     * 转发一个RTP包，开启平滑发送时先进入本会话的发送节拍队列
+     * @param key 是否为关键帧访问单元（含前面的SPS/PPS）的第一个包，丢包后从这里恢复
+     */
+    void sendRtp(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload, bool key) {
+        if (_wait_key && !key) return;
+        if (sendQueueBytes() + (_pacer ? _pacer->queuedBytes() : 0) > kMaxSendQueue) {
+            _wait_key = true;
+            if (_pacer) _pacer->clear();
+            return;
+        }
+        _wait_key = false;
+
+        if (_pacer) {
+            _pacer->push(PacedRtp{pkt, payload}, 16 + payload->size(), pkt->timestamp);
+            return;
+        }
+        writeRtp(pkt, payload);
+    }
+
+    bool playing() const { return _playing; }
+
+protected:
+    void onRecv(const toolkit::Buffer::Ptr& buf) override {
+        _splitter.input(buf->data(), buf->size());
+    }
+
+private:
+    // 写出一个RTP包：只构造本会话的RTP头，负载共享
+    void writeRtp(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload) {
+        uint16_t seq = _seq++;
+        char head[16];
+        char* rtp = head + 4;
+        rtp[0] = (char)(0x80 | (pkt->padding << 5));
+        rtp[1] = (char)((pkt->marker << 7) | pkt->pt);
+        rtp[2] = (char)(seq >> 8);
+        rtp[3] = (char)seq;
+        rtp[4] = (char)(pkt->timestamp >> 24);
+        rtp[5] = (char)(pkt->timestamp >> 16);
+        rtp[6] = (char)(pkt->timestamp >> 8);
+        rtp[7] = (char)pkt->timestamp;
+        rtp[8] = (char)(_ssrc >> 24);
+        rtp[9] = (char)(_ssrc >> 16);
+        rtp[10] = (char)(_ssrc >> 8);
+        rtp[11] = (char)_ssrc;
+
+        if (_udp_fd >= 0) {
+            struct iovec iov[2];
+            iov[0].iov_base = rtp;
+            iov[0].iov_len = 12;
+            iov[1].iov_base = payload->data();
+            iov[1].iov_len = payload->size();
+            struct msghdr msg{};
+            msg.msg_name = &_udp_peer;
+            msg.msg_namelen = sizeof(_udp_peer);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+            ::sendmsg(_udp_fd, &msg, MSG_DONTWAIT);  // UDP发送失败直接丢弃
+            return;
+        }
+
+        size_t len = 12 + payload->size();
+        head[0] = '$';
+        head[1] = (char)_interleaved;
+        head[2] = (char)(len >> 8);
+        head[3] = (char)len;
+        send(head, sizeof(head), payload);
+    }
+
+    void onRequest(const std::string& req);
+
+    static std::string getHeader(const std::string& req, const char* name) {
+        std::string key = std::string("\r\n") + name + ":";
+        size_t pos = req.find(key);
+        if (pos == std::string::npos) return "";
+        size_t start = pos + key.size();
+        while (start < req.size() && req[start] == ' ') start++;
+        size_t end = req.find("\r\n", start);
+        return req.substr(start, end - start);
+    }
+
+    void sendResponse(int code, const char* msg, const std::string& cseq,
+                      const std::string& headers = "", const std::string& body = "") {
+        std::string resp = "RTSP/1.0 " + std::to_string(code) + " " + msg + "\r\n"
+                           "CSeq: " + cseq + "\r\n"
+                           "Server: SimplePlayer\r\n" + headers;
+        if (_source && code == 200) resp += "Session: " + _session_id + ";timeout=60\r\n";
+        if (!body.empty()) resp += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        resp += "\r\n" + body;
+        send(resp);
+    }
+
+    // rtsp://host:port/name[/trackID=0] -> name
+    static std::string streamName(const std::string& url) {
+        size_t pos = url.find("://");
+        pos = url.find('/', pos == std::string::npos ? 0 : pos + 3);
+        if (pos == std::string::npos) return "";
+        std::string path = url.substr(pos + 1);
+        path = path.substr(0, path.find('?'));
+        size_t track = path.rfind("/trackID=");
+        if (track != std::string::npos) path = path.substr(0, track);
+        while (!path.empty() && path.back() == '/') path.pop_back();
+        return path;
+    }
+
+    bool setupTransport(const std::string& transport, std::string& reply);
+
+private:
+    std::weak_ptr<RtspServer> _server;
+    RtspSplitter _splitter;
+    RtspRelaySource::Ptr _source;
+    std::string _session_id;
+    uint32_t _ssrc = 0;
+    uint16_t _seq = 0;
+    int _interleaved = 0;
+    int _udp_fd = -1;
+    sockaddr_in _udp_peer{};
+    bool _playing = false;
+    bool _wait_key = true;
+    toolkit::PacedQueue<PacedRtp>::Ptr _pacer;
+};
+
+/**
+ * RTSP转发服务器：OPTIONS/DESCRIBE/SETUP/PLAY/TEARDOWN/GET_PARAMETER
+ * 访问 rtsp://host:port/<name>
+ * 在一个loop上accept，下游会话分散到EventPollerPool的各个loop
+ */
+class RtspServer : public std::enable_shared_from_this<RtspServer> {
+public:
+    using Ptr = std::shared_ptr<RtspServer>;
+
+    explicit RtspServer(const toolkit::EventPoller::Ptr& poller = nullptr)
+        : _server(std::make_shared<toolkit::TcpServer>(poller)) {
+        _server->setMultiPoller(true);
+    }
+
+    ~RtspServer() {
+        _server->stop();
+        if (_udp_fd >= 0) ::close(_udp_fd);
+    }
+
+    /**
+     * 开始监听
+     * @param port RTSP端口，0表示随机端口
+     */
+    bool start(uint16_t port, const std::string& local_ip = "0.0.0.0") {
+        // 所有UDP下游共用一个发送socket
+        _udp_fd = toolkit::SockUtil::bindUdpSock(0, local_ip.c_str());
+        std::weak_ptr<RtspServer> weak_self = shared_from_this();
+        auto pacing = _pacing;
+        return _server->start(port, [weak_self, pacing](const toolkit::EventPoller::Ptr& poller, int fd) {
+            return std::make_shared<RtspServerSession>(poller, fd, weak_self, pacing);
+        }, local_ip);
+    }
+
+    uint16_t getPort() const { return _server->getPort(); }
+
+    /**
+     * 下游平滑发送，必须在start之前调用，默认关闭
+     */
+    void setPacing(const RtspServerSession::Pacing& pacing) { _pacing = pacing; }
+
+    int getUdpFd() const { return _udp_fd; }
+
+    /**
+     * 发布一路拉流，可在任意线程调用
+     * @param name 流名，对应URL路径
+     * @param client 拉流客户端
+     */
+    void addStream(const std::string& name, const RtspClient::Ptr& client) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& stream = _streams[name];
+        stream.client = client;
+        stream.sources.clear();
+    }
+
+    void removeStream(const std::string& name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _streams.erase(name);
+    }
+
+    /**
+     * 查找流在指定loop上的转发源，没有则创建并挂到RingBuffer（回放GOP缓存）
+     * 在会话所在loop调用，同一loop上的下游共用一个转发源，每批数据每个loop只分发一次
+     */
+    RtspRelaySource::Ptr findSource(const std::string& name, const toolkit::EventPoller::Ptr& poller) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _streams.find(name);
+        if (it == _streams.end()) return nullptr;
+        auto& source = it->second.sources[poller.get()];
+        if (!source) {
+            auto client = it->second.client.lock();
+            if (!client) return nullptr;
+            source = std::make_shared<RtspRelaySource>(poller, client);
+            source->start();
+        }
+        return source;
+    }
+
+private:
+    struct Stream {
+        std::weak_ptr<RtspClient> client;
+        std::unordered_map<toolkit::EventPoller*, RtspRelaySource::Ptr> sources;
+    };
+
+    toolkit::TcpServer::Ptr _server;
+    RtspServerSession::Pacing _pacing;
+    int _udp_fd = -1;
+    // 会话在各自的loop上查找
+    std::mutex _mutex;
+    std::unordered_map<std::string, Stream> _streams;
+};
+
+inline void RtspRelaySource::addPlayer(const RtspServerSession::Ptr& session) {
+    for (size_t i = 0; i < _gop.size(); ++i) {
+        session->sendRtp(_gop[i].pkt, _gop[i].payload, i == 0);
+    }
+    _players.emplace_back(session);
+}
+
+inline void RtspRelaySource::dispatch(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload, bool key) {
+    if (pkt->isParameterSet()) {
+        if (!_prefix.empty() && _prefix.front().pkt->timestamp != pkt->timestamp) {
+            for (auto& cached : _prefix) forward(cached.pkt, cached.payload, false);
+            _prefix.clear();
+        }
+        _prefix.push_back({pkt, payload});
+        return;
+    }
+
+    // 多slice的IDR每个slice都有起始包，时间戳不变时属于同一个关键帧
+    bool gop_start = key && (!_have_key || pkt->timestamp != _key_timestamp);
+    if (gop_start) {
+        _have_key = true;
+        _key_timestamp = pkt->timestamp;
+    }
+    // 紧挨着的同一时间戳的参数集属于这个关键帧，访问单元从第一个参数集开始
+    bool with_prefix = gop_start && !_prefix.empty() && _prefix.front().pkt->timestamp == pkt->timestamp;
+    for (size_t i = 0; i < _prefix.size(); ++i) {
+        forward(_prefix[i].pkt, _prefix[i].payload, with_prefix && i == 0);
+    }
+    _prefix.clear();
+    forward(pkt, payload, gop_start && !with_prefix);
+}
+
+inline void RtspRelaySource::forward(const RtpPacket::Ptr& pkt, const toolkit::Buffer::Ptr& payload, bool key) {
+    // GOP缓存上限（包数），防止超长GOP占用过多内存
+    static constexpr size_t kMaxGopPackets = 8192;
+    if (key) {
+        _gop.clear();
+    }
+    if (!_gop.empty() || key) {
+        if (_gop.size() < kMaxGopPackets) _gop.push_back({pkt, payload});
+    }
+
+    for (size_t i = 0; i < _players.size();) {
+        auto player = _players[i].lock();
+        if (!player || !player->alive()) {
+            _players[i] = std::move(_players.back());
+            _players.pop_back();
+            continue;
+        }
+        player->sendRtp(pkt, payload, key);
+        ++i;
+    }
+}
+
+inline bool RtspServerSession::setupTransport(const std::string& transport, std::string& reply) {
+    size_t pos = transport.find("interleaved=");
+    if (transport.find("RTP/AVP/TCP") != std::string::npos || pos != std::string::npos) {
+        _interleaved = pos != std::string::npos ? atoi(transport.c_str() + pos + 12) : 0;
+        reply = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(_interleaved) + "-" +
+                std::to_string(_interleaved + 1);
+        return true;
+    }
+
+    pos = transport.find("client_port=");
+    auto server = _server.lock();
+    if (pos == std::string::npos || !server || server->getUdpFd() < 0) return false;
+
+    int rtp_port = atoi(transport.c_str() + pos + 12);
+    _udp_peer.sin_family = AF_INET;
+    _udp_peer.sin_port = htons((uint16_t)rtp_port);
+    inet_pton(AF_INET, getPeerIP().c_str(), &_udp_peer.sin_addr);
+    _udp_fd = server->getUdpFd();
+
+    uint16_t server_port = toolkit::SockUtil::getLocalPort(_udp_fd);
+    reply = "RTP/AVP;unicast;client_port=" + std::to_string(rtp_port) + "-" + std::to_string(rtp_port + 1) +
+            ";server_port=" + std::to_string(server_port) + "-" + std::to_string(server_port + 1) +
+            ";ssrc=" + [this]() { char s[9]; snprintf(s, sizeof(s), "%08X", _ssrc); return std::string(s); }();
+    return true;
+}
+
+inline void RtspServerSession::onRequest(const std::string& req) {
+    char method[32] = {0}, url[1024] = {0};
+    if (sscanf(req.c_str(), "%31s %1023s", method, url) != 2) {
+        shutdown(toolkit::SockException(toolkit::Err_other, "bad request"));
+        return;
+    }
+    std::string cseq = getHeader(req, "CSeq");
+    std::string m = method;
+    auto server = _server.lock();
+
+    if (m == "OPTIONS") {
+        sendResponse(200, "OK", cseq, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n");
+    } else if (m == "DESCRIBE") {
+        auto source = server ? server->findSource(streamName(url), getPoller()) : nullptr;
+        std::string sdp = source ? source->getSdp() : "";
+        if (sdp.empty()) {
+            sendResponse(404, "Not Found", cseq);
+            return;
+        }
+        std::string base = url;
+        if (base.back() != '/') base += '/';
+        sendResponse(200, "OK", cseq,
+                     "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n", sdp);
+    } else if (m == "SETUP") {
+        _source = server ? server->findSource(streamName(url), getPoller()) : nullptr;
+        std::string reply;
+        if (!_source) {
+            sendResponse(404, "Not Found", cseq);
+        } else if (!setupTransport(getHeader(req, "Transport"), reply)) {
+            sendResponse(461, "Unsupported Transport", cseq);
+        } else {
+            sendResponse(200, "OK", cseq, "Transport: " + reply + "\r\n");
+        }
+    } else if (m == "PLAY") {
+        if (!_source) {
+            sendResponse(455, "Method Not Valid in This State", cseq);
+            return;
+        }
+        sendResponse(200, "OK", cseq, "Range: npt=0.000-\r\nRTP-Info: url=" + std::string(url) +
+                     "/trackID=0;seq=" + std::to_string(_seq) + "\r\n");
+        if (!_playing) {
+            _playing = true;
+            _source->addPlayer(std::static_pointer_cast<RtspServerSession>(shared_from_this()));
+        }
+    } else if (m == "GET_PARAMETER" || m == "SET_PARAMETER") {
+        sendResponse(200, "OK", cseq);
+    } else if (m == "TEARDOWN") {
+        sendResponse(200, "OK", cseq);
+        shutdown(toolkit::SockException(toolkit::Err_shutdown, "teardown"));
+    } else {
+        sendResponse(501, "Not Implemented", cseq);
+    }
+}
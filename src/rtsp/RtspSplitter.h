@@ -43,6 +43,13 @@ public:
     }
 
     void enableRtp(bool enable) { _rtp_mode = enable; }
+
+    // 清空缓存并回到RTSP模式，重连时使用
+    void reset() {
+        _buffer.clear();
+        _rtp_mode = false;
+    }
+
     void setOnResponse(std::function<void(const std::string&)> cb) { _on_response = cb; }
     void setOnRtp(std::function<void(const char*, size_t, int)> cb) { _on_rtp = cb; }
 
@@ -0,0 +1,127 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include "rtsp/RtspClient.h"
+#include "rtsp/H264RtpDecoder.h"
+#include "util/ShmRing.h"
+#include "util/Logger.h"
+
+/**
+ * 把一路流导出到共享内存，供本机其他进程零拷贝读取（推理、录像等）
+ * 1. 在RingBuffer写线程解包，每帧以AVCC格式直接写入共享内存环，不经过socket
+ * 2. 关键帧前附带SPS/PPS（同为4字节长度前缀），读者从任意关键帧开始都能独立解码
+ * 3. SDP写入段的元数据区，读者用ShmRingReader::meta()获取
+ * 读者只需包含util/ShmRing.h，用toolkit::ShmRingReader按名字打开，futex等待新帧
+ * 慢读者只会被覆盖而跳帧，不会拖慢写线程，也不会影响其他读者
+ */
+class ShmRingExport : public std::enable_shared_from_this<ShmRingExport>,
+                      public RingReaderBase<RtpPacket::Ptr> {
+public:
+    using Ptr = std::shared_ptr<ShmRingExport>;
+
+    ~ShmRingExport() {
+        if (auto ring = _ring.lock()) {
+            ring->detach(_reader_id);
+        }
+    }
+
+    /**
+     * 创建共享内存段
+     * @param name POSIX共享内存名，如"/cam1"，读者用同一名字打开；为空时使用memfd，由fd()传给读者
+     * @param capacity 数据区大小（字节），按码率估算，如4Mbps保存10秒约需5MB
+     * @param max_keyframes 关键帧索引容量
+     */
+    bool open(const std::string& name, uint64_t capacity = 32ULL << 20, uint32_t max_keyframes = 1024) {
+        if (!_writer.create(name, capacity, max_keyframes)) {
+            WarnL("create shm ring %s failed: %s", name.c_str(), strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * 挂到RtspClient的RingBuffer上开始导出，必须在open成功后调用
+     * 以裸指针挂载，析构时detach（原因见HttpMediaStream::start）
+     */
+    void start(const RtspClient::Ptr& client) {
+        _client = client;
+        _ring = client->getRing();
+        _reader_id = client->getRing()->attach(this);
+    }
+
+    int fd() const { return _writer.fd(); }
+    const std::string& name() const { return _writer.name(); }
+
+private:
+    // RingBuffer写线程，整批写完后只唤醒一次读者
+    void onBatch(const RingSpan<RtpPacket::Ptr>& batch) override {
+        if (!_decoder) {
+            _decoder = std::make_shared<H264RtpDecoder>();
+            if (auto client = _client.lock()) {
+                std::string sdp = client->getSdp();
+                _decoder->setSdp(sdp);
+                _writer.setMeta(sdp);
+            }
+            _decoder->setOnFrame([this](const H264Frame::Ptr& frame) { onFrame(frame); });
+        }
+        _wall_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        _written = false;
+        for (auto& pkt : batch) {
+            _decoder->input(pkt);
+        }
+        if (_written) _writer.notify();
+    }
+
+    // RingBuffer写线程
+    void onFrame(const H264Frame::Ptr& frame) {
+        if (!_decoder->ready()) return;
+        if (_wait_key && !frame->key) return;
+        _wait_key = false;
+
+        bool ok;
+        if (frame->key) {
+            const std::string& sps = _decoder->getSps();
+            const std::string& pps = _decoder->getPps();
+            char sps_len[4], pps_len[4];
+            putLength(sps_len, sps.size());
+            putLength(pps_len, pps.size());
+            ok = _writer.write(frame->timestamp, true, _wall_us,
+                               {{sps_len, 4}, {sps.data(), sps.size()},
+                                {pps_len, 4}, {pps.data(), pps.size()},
+                                {frame->data.data(), frame->data.size()}});
+        } else {
+            ok = _writer.write(frame->timestamp, false, _wall_us, {{frame->data.data(), frame->data.size()}});
+        }
+        if (!ok) {
+            // 帧超过环的1/4，之后的帧依赖它，等下一个关键帧
+            WarnL("frame too large for shm ring %s: %zu bytes", _writer.name().c_str(), frame->data.size());
+            _wait_key = true;
+            return;
+        }
+        _written = true;
+    }
+
+    static void putLength(char* out, size_t len) {
+        uint32_t n = (uint32_t)len;
+        out[0] = (char)(n >> 24);
+        out[1] = (char)(n >> 16);
+        out[2] = (char)(n >> 8);
+        out[3] = (char)n;
+    }
+
+private:
+    std::weak_ptr<RtspClient> _client;
+    std::weak_ptr<RtspClient::RingType> _ring;
+    RtspClient::RingType::ReaderId _reader_id = 0;
+
+    // 以下只在RingBuffer写线程访问
+    toolkit::ShmRingWriter _writer;
+    H264RtpDecoder::Ptr _decoder;
+    int64_t _wall_us = 0;
+    bool _written = false;
+    bool _wait_key = true;
+};
@@ -0,0 +1,357 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "rtsp/RtpPacket.h"
+#include "util/RingBuffer.h"
+#include "util/RecordRing.h"
+#include "util/Logger.h"
+
+/**
+ * 单路流的时移缓冲（DVR），保存最近一段时间的RTP包用于回看
+ * 1. 数据写入预分配的环形文件，按顺序追加，写满后从头覆盖最旧的数据
+ * 2. 文件整体mmap，读者直接引用页缓存中的数据，不拷贝
+ * 3. 关键帧索引是预分配的定长环形数组，按RTP时间戳和wall clock查找关键帧位置
+ * 运行期间不随码流增长分配堆内存，单机可同时跑数百路
+ *
+ * 写入只在RingBuffer写线程，读者可在任意线程，读路径无锁（记录布局和覆盖检测见toolkit::RecordRing）
+ */
+class TimeShiftBuffer : public std::enable_shared_from_this<TimeShiftBuffer>,
+                        public RingReaderBase<RtpPacket::Ptr> {
+public:
+    using Ptr = std::shared_ptr<TimeShiftBuffer>;
+    using RingType = RingBuffer<RtpPacket::Ptr>;
+
+    /**
+     * 读到的一个RTP包，payload指向映射内存，被写者覆盖后失效（见Reader::valid）
+     */
+    struct Record {
+        uint64_t pos = 0;        // 逻辑位置（累计写入字节数）
+        uint32_t timestamp = 0;
+        uint32_t ssrc = 0;
+        uint16_t seq = 0;
+        uint8_t pt = 0;
+        bool marker = false;
+        bool key = false;
+        int64_t wall_us = 0;     // 收到该包时的unix时间(us)
+        const char* payload = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * 读游标，先seek到某个关键帧，再用next顺序读取
+     * 读得比写慢一整圈时自动跳到最旧的关键帧，lapped()计数加一
+     */
+    class Reader {
+    public:
+        explicit Reader(const Ptr& buffer) : _buffer(buffer) {}
+
+        /**
+         * 定位到不晚于wall_us的最后一个关键帧，早于缓冲起点时定位到最旧的关键帧
+         * @return 缓冲中还没有关键帧时返回false
+         */
+        bool seekTime(int64_t wall_us) { return _buffer->findKey(_pos, wall_us, kByWall); }
+
+        /**
+         * 定位到不晚于该RTP时间戳的最后一个关键帧，时间戳按当前会话的时间轴解释（处理32位回绕）
+         */
+        bool seekRtp(uint32_t timestamp) { return _buffer->findKey(_pos, timestamp, kByRtp); }
+
+        bool seekOldest() { return _buffer->findKey(_pos, INT64_MIN, kByWall); }
+        bool seekLatest() { return _buffer->findKey(_pos, INT64_MAX, kByWall); }
+
+        /**
+         * 读下一个包
+         * @return 已追上写者时返回false，之后可以继续调用
+         */
+        bool next(Record& rec) { return _buffer->readAt(_pos, rec, _lapped); }
+
+        /**
+         * 使用完rec.payload之后调用，返回false说明读取期间数据已被覆盖，应丢弃
+         */
+        bool valid(const Record& rec) const { return _buffer->valid(rec.pos); }
+
+        uint64_t position() const { return _pos; }
+        uint64_t lapped() const { return _lapped; }
+
+    private:
+        Ptr _buffer;
+        uint64_t _pos = 0;
+        uint64_t _lapped = 0;
+    };
+
+    /**
+     * @param capacity 文件大小（字节），按1MB向上取整；按码率估算，如4Mbps保存30分钟约需900MB
+     * @param max_keyframes 关键帧索引容量，超过后丢弃最旧的索引项
+     */
+    explicit TimeShiftBuffer(uint64_t capacity = 256ULL << 20, size_t max_keyframes = 4096)
+        : _capacity((std::max<uint64_t>(capacity, kChunk) + kChunk - 1) / kChunk * kChunk),
+          _keys(max_keyframes ? max_keyframes : 1) {}
+
+    ~TimeShiftBuffer() {
+        if (auto ring = _ring.lock()) {
+            ring->detach(_reader_id);
+        }
+        if (_base) munmap(_base, _capacity);
+        if (_fd >= 0) ::close(_fd);
+    }
+
+    /**
+     * 创建并预分配缓冲文件，已有内容不会被恢复
+     * 预分配保证写入时不会因为磁盘满在映射内存上触发SIGBUS
+     */
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            WarnL("open %s failed: %s", path.c_str(), strerror(errno));
+            return false;
+        }
+        int err = 0;
+        if (ftruncate(fd, (off_t)_capacity) != 0) {
+            err = errno;
+        } else {
+            err = posix_fallocate(fd, 0, (off_t)_capacity);
+        }
+        if (err) {
+            WarnL("allocate %s (%llu bytes) failed: %s", path.c_str(), (unsigned long long)_capacity, strerror(err));
+            ::close(fd);
+            return false;
+        }
+        void* base = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            WarnL("mmap %s failed: %s", path.c_str(), strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        _fd = fd;
+        _base = (char*)base;
+        _records = Records(_base, _capacity, &_head, &_tail);
+        prefetch(0);
+        return true;
+    }
+
+    /**
+     * 挂到RtspClient的RingBuffer上开始录制，必须在open成功后调用
+     * 以裸指针挂载，析构时detach（原因见HttpMediaStream::start）
+     */
+    void start(const RingType::Ptr& ring) {
+        _ring = ring;
+        _reader_id = ring->attach(this);
+    }
+
+    Reader createReader() { return Reader(shared_from_this()); }
+
+    /**
+     * 写入一个包，只能在单一线程调用
+     * 关键帧按访问单元索引：多slice的IDR只记一项，位置为其前面同一时间戳的SPS/PPS（没有时为第一个IDR包）
+     */
+    void write(const RtpPacket& pkt, int64_t wall_us) {
+        if (!_base) return;
+        bool key = pkt.isKeyFrame();
+        RecordHeader header{};
+        header.timestamp = pkt.timestamp;
+        header.ssrc = pkt.ssrc;
+        header.seq = pkt.seq;
+        header.pt = pkt.pt;
+        header.flags = (pkt.marker ? kFlagMarker : 0) | (key ? kFlagKey : 0);
+        header.wall_us = wall_us;
+        uint64_t pos;
+        if (!_records.append(header, {{pkt.payload.data(), pkt.payload.size()}}, pos)) return;
+
+        uint64_t end = _head.load(std::memory_order_relaxed);
+        if (end / kChunk != pos / kChunk) prefetch(end / kChunk + 1);
+        _latest_wall_us.store(wall_us, std::memory_order_relaxed);
+
+        if (_have_rtp) {
+            _ext_rtp += (int32_t)(pkt.timestamp - _last_rtp);
+        } else {
+            _ext_rtp = pkt.timestamp;
+            _have_rtp = true;
+        }
+        _last_rtp = pkt.timestamp;
+
+        if (pkt.isParameterSet()) {
+            if (!_have_prefix || _prefix_rtp != pkt.timestamp) {
+                _have_prefix = true;
+                _prefix_rtp = pkt.timestamp;
+                _prefix_pos = pos;
+            }
+            return;
+        }
+        bool key_start = key && (!_have_key || pkt.timestamp != _key_rtp);
+        bool with_prefix = _have_prefix && _prefix_rtp == pkt.timestamp;
+        _have_prefix = false;
+        if (key_start) {
+            _have_key = true;
+            _key_rtp = pkt.timestamp;
+            if (with_prefix) pos = _prefix_pos;
+            std::lock_guard<std::mutex> lock(_index_mutex);
+            size_t idx = (_key_first + _key_count) % _keys.size();
+            if (_key_count == _keys.size()) {
+                _key_first = (_key_first + 1) % _keys.size();
+            } else {
+                ++_key_count;
+            }
+            _keys[idx] = KeyEntry{pos, _ext_rtp, wall_us};
+        }
+    }
+
+    uint64_t capacity() const { return _capacity; }
+
+    // 当前可回看的数据量（字节）
+    uint64_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * 可回看的时间范围（unix时间，us），从最旧的有效关键帧到最新写入的包
+     * @return 没有关键帧时返回false
+     */
+    bool range(int64_t& oldest_us, int64_t& latest_us) {
+        std::lock_guard<std::mutex> lock(_index_mutex);
+        size_t first = firstValidKey();
+        if (first == _key_count) return false;
+        oldest_us = keyAt(first).wall_us;
+        latest_us = _latest_wall_us.load(std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    // RingBuffer写线程，整批共用一次取时间
+    void onBatch(const RingSpan<RtpPacket::Ptr>& batch) override {
+        int64_t wall_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (auto& pkt : batch) {
+            write(*pkt, wall_us);
+        }
+    }
+
+    struct RecordHeader {
+        uint32_t size;
+        uint32_t timestamp;
+        uint32_t ssrc;
+        uint16_t seq;
+        uint8_t pt;
+        uint8_t flags;
+        int64_t wall_us;
+    };
+    static_assert(sizeof(RecordHeader) == 24, "record header must stay 8-byte aligned");
+    using Records = toolkit::RecordRing<RecordHeader>;
+
+    struct KeyEntry {
+        uint64_t pos;
+        int64_t ext_rtp;   // 展开回绕后的RTP时间戳
+        int64_t wall_us;
+    };
+
+    enum SeekBy { kByWall, kByRtp };
+
+    // 0x80为RecordRing的回绕标记
+    static constexpr uint8_t kFlagMarker = 1;
+    static constexpr uint8_t kFlagKey = 2;
+    // 预读粒度，写者跨过一块时提前让内核异步读入下一块，避免覆盖已被换出的页时在收包线程上同步读盘
+    static constexpr uint64_t kChunk = 1 << 20;
+
+    void prefetch(uint64_t chunk) {
+        madvise(_base + (chunk * kChunk) % _capacity, kChunk, MADV_WILLNEED);
+    }
+
+    bool valid(uint64_t pos) const { return _records.valid(pos); }
+
+    bool readAt(uint64_t& pos, Record& rec, uint64_t& lapped) {
+        if (!_base) return false;
+        Records::View view;
+        for (;;) {
+            auto ret = _records.read(pos, view);
+            if (ret == Records::kEnd) return false;
+            if (ret == Records::kRead) break;
+            ++lapped;
+            if (!findKey(pos, INT64_MIN, kByWall)) return false;
+        }
+        rec.pos = view.pos;
+        rec.timestamp = view.header.timestamp;
+        rec.ssrc = view.header.ssrc;
+        rec.seq = view.header.seq;
+        rec.pt = view.header.pt;
+        rec.marker = (view.header.flags & kFlagMarker) != 0;
+        rec.key = (view.header.flags & kFlagKey) != 0;
+        rec.wall_us = view.header.wall_us;
+        rec.payload = view.data;
+        rec.size = view.header.size;
+        return true;
+    }
+
+    // 以下持_index_mutex调用
+    const KeyEntry& keyAt(size_t i) const { return _keys[(_key_first + i) % _keys.size()]; }
+
+    // 第一个未被覆盖的关键帧，全部失效时返回_key_count
+    size_t firstValidKey() const {
+        uint64_t tail = _tail.load(std::memory_order_acquire);
+        size_t lo = 0, hi = _key_count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (keyAt(mid).pos < tail) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    bool findKey(uint64_t& pos, int64_t target, SeekBy by) {
+        std::lock_guard<std::mutex> lock(_index_mutex);
+        size_t first = firstValidKey();
+        if (first == _key_count) return false;
+        if (by == kByRtp) {
+            // 相对最新关键帧展开回绕
+            int64_t newest = keyAt(_key_count - 1).ext_rtp;
+            target = newest + (int32_t)((uint32_t)target - (uint32_t)newest);
+        }
+        // 最后一个不晚于target的关键帧
+        size_t lo = first, hi = _key_count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            const auto& key = keyAt(mid);
+            if ((by == kByWall ? key.wall_us : key.ext_rtp) <= target) lo = mid + 1;
+            else hi = mid;
+        }
+        pos = keyAt(lo > first ? lo - 1 : first).pos;
+        return true;
+    }
+
+private:
+    uint64_t _capacity;
+    int _fd = -1;
+    char* _base = nullptr;
+    std::atomic<uint64_t> _head{0};
+    std::atomic<uint64_t> _tail{0};
+    Records _records;
+    std::atomic<int64_t> _latest_wall_us{0};
+
+    // 写线程
+    bool _have_rtp = false;
+    uint32_t _last_rtp = 0;
+    int64_t _ext_rtp = 0;
+    // 当前关键帧的时间戳，以及待定的SPS/PPS起始位置
+    bool _have_key = false;
+    uint32_t _key_rtp = 0;
+    bool _have_prefix = false;
+    uint32_t _prefix_rtp = 0;
+    uint64_t _prefix_pos = 0;
+
+    std::mutex _index_mutex;
+    std::vector<KeyEntry> _keys;
+    size_t _key_first = 0;
+    size_t _key_count = 0;
+
+    std::weak_ptr<RingType> _ring;
+    RingType::ReaderId _reader_id = 0;
+};
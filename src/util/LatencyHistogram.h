@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace toolkit {
+
+/**
+ * 延时直方图（微秒），对数线性分桶：每个2的幂区间16个子桶，相对误差约6%
+ * record为无锁原子累加，可在收包线程写、任意线程读
+ */
+class LatencyHistogram {
+public:
+    void record(int64_t us) {
+        if (us < 0) us = 0;
+        _buckets[bucketOf((uint64_t)us)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add((uint64_t)us, std::memory_order_relaxed);
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while ((uint64_t)us > max && !_max.compare_exchange_weak(max, (uint64_t)us, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+
+    uint64_t mean() const {
+        uint64_t n = count();
+        return n ? _sum.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    /**
+     * 百分位数，返回所在桶的上界
+     * @param p 0~100
+     */
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t target = (uint64_t)(n * p / 100.0);
+        if (target >= n) target = n - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += _buckets[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                uint64_t upper = bucketUpper(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    void reset() {
+        for (auto& bucket : _buckets) bucket.store(0, std::memory_order_relaxed);
+        _count = 0;
+        _sum = 0;
+        _max = 0;
+    }
+
+    std::string toString() const {
+        char buf[160];
+        snprintf(buf, sizeof(buf), "n=%llu mean=%lluus p50=%lluus p90=%lluus p99=%lluus max=%lluus",
+                 (unsigned long long)count(), (unsigned long long)mean(),
+                 (unsigned long long)percentile(50), (unsigned long long)percentile(90),
+                 (unsigned long long)percentile(99), (unsigned long long)max());
+        return buf;
+    }
+
+private:
+    static constexpr int kSubBits = 4;
+    static constexpr uint64_t kSubCount = 1 << kSubBits;
+    // 覆盖到2^40us（约12天）
+    static constexpr size_t kBuckets = (40 - kSubBits + 1) * kSubCount + kSubCount;
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < kSubCount) return (size_t)v;
+        int msb = 63 - __builtin_clzll(v);
+        if (msb > 40) return kBuckets - 1;
+        int shift = msb - kSubBits;
+        return (size_t)(shift + 1) * kSubCount + ((v >> shift) & (kSubCount - 1));
+    }
+
+    static uint64_t bucketUpper(size_t idx) {
+        if (idx < kSubCount) return idx;
+        int shift = (int)(idx / kSubCount) - 1;
+        uint64_t sub = idx % kSubCount;
+        return (((kSubCount | sub) + 1) << shift) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> _buckets[kBuckets] = {};
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _sum{0};
+    std::atomic<uint64_t> _max{0};
+};
+
+} // namespace toolkit
@@ -0,0 +1,472 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace toolkit {
+
+enum LogLevel { LTrace = 0, LDebug, LInfo, LWarn, LError, LNone };
+
+// 编译期日志级别，低于该级别的日志语句整体不参与编译
+#ifndef LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define LOG_ACTIVE_LEVEL 2  // LInfo
+#else
+#define LOG_ACTIVE_LEVEL 1  // LDebug
+#endif
+#endif
+
+/**
+ * 异步日志
+ * 1. 每个线程一个无锁单生产者/单消费者环形缓冲，写日志只拷贝参数，不加锁、不格式化
+ * 2. 格式串必须是字面量，只保存指针；字符串参数按值拷贝进缓冲
+ * 3. 后台线程定期取出所有线程的记录，按时间排序后格式化并写出
+ * 4. 缓冲满时直接丢弃并计数，不阻塞调用线程
+ */
+class Logger {
+public:
+    /**
+     * 运行期日志级别
+     */
+    static void setLevel(LogLevel level) { levelRef() = level; }
+    static bool enabled(int level) { return level >= levelRef().load(std::memory_order_relaxed); }
+
+    /**
+     * 设置输出，默认stderr
+     */
+    static void setOutput(FILE* out) {
+        auto& logger = Instance();
+        std::lock_guard<std::mutex> lock(logger._mutex);
+        logger._out = out ? out : stderr;
+    }
+
+    /**
+     * 写入一条日志，只在当前线程的缓冲中拷贝参数
+     */
+    template <typename... Args>
+    static void write(int level, const char* file, int line, const char* fmt, const Args&... args) {
+        auto& buffer = threadBuffer();
+        size_t size = sizeof(Record) + argsSize(args...);
+        size = (size + 7) & ~(size_t)7;
+
+        uint8_t* ptr = buffer.reserve(size);
+        if (!ptr) return;
+
+        Record record{};
+        record.size = (uint32_t)size;
+        record.level = (uint16_t)level;
+        record.line = (uint32_t)line;
+        record.tid = buffer.tid;
+        record.fmt = fmt;
+        record.file = file;
+        record.format = &formatArgs<typename std::decay<Args>::type...>;
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        memcpy(ptr, &record, sizeof(record));
+        encodeArgs(ptr + sizeof(Record), args...);
+        buffer.commit(size);
+    }
+
+    /**
+     * 立即写出所有缓冲中的日志
+     */
+    static void flush() { Instance().flushAll(); }
+
+    // 只用于编译期检查printf格式
+    static void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2))) {}
+
+private:
+    using FormatFn = void (*)(const char* fmt, const uint8_t* args, std::string& out);
+
+    struct Record {
+        uint32_t size;
+        uint16_t level;
+        uint16_t reserved;
+        uint32_t line;
+        uint32_t tid;
+        const char* fmt;
+        const char* file;
+        FormatFn format;
+        int64_t time_ns;
+    };
+
+    /**
+     * 单生产者/单消费者环形缓冲，读写位置单调递增
+     * 记录不跨越缓冲末尾，剩余空间不够时写入size为0的回绕标记
+     */
+    class ThreadBuffer {
+    public:
+        static constexpr size_t kSize = 256 * 1024;
+        static constexpr size_t kMask = kSize - 1;
+
+        uint8_t* reserve(size_t size) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            size_t tail = _tail.load(std::memory_order_acquire);
+            size_t offset = head & kMask;
+            size_t contiguous = kSize - offset;
+            size_t need = contiguous < size ? contiguous + size : size;
+            if (need > kSize - (head - tail)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            _skip = 0;
+            if (contiguous < size) {
+                uint32_t wrap = 0;
+                memcpy(_data + offset, &wrap, sizeof(wrap));
+                _skip = contiguous;
+                offset = 0;
+            }
+            return _data + offset;
+        }
+
+        void commit(size_t size) {
+            _head.store(_head.load(std::memory_order_relaxed) + _skip + size, std::memory_order_release);
+        }
+
+        /**
+         * 消费者取出所有已提交的记录
+         */
+        template <typename Func>
+        void consume(Func&& func) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            size_t head = _head.load(std::memory_order_acquire);
+            while (tail != head) {
+                size_t offset = tail & kMask;
+                uint32_t size;
+                memcpy(&size, _data + offset, sizeof(size));
+                if (size == 0) {
+                    tail += kSize - offset;
+                    continue;
+                }
+                func(_data + offset);
+                tail += size;
+            }
+            _tail.store(tail, std::memory_order_release);
+        }
+
+        bool empty() const {
+            return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed);
+        }
+
+        uint32_t tid = 0;
+        std::atomic<bool> retired{false};
+        std::atomic<uint64_t> dropped{0};
+
+    private:
+        alignas(64) std::atomic<size_t> _head{0};
+        size_t _skip = 0;
+        alignas(64) std::atomic<size_t> _tail{0};
+        alignas(64) uint8_t _data[kSize];
+    };
+
+    // 线程退出时标记缓冲，由后台线程写完剩余日志后回收
+    struct ThreadBufferHolder {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadBufferHolder() {
+            if (buffer) buffer->retired = true;
+        }
+    };
+
+    // 参数编解码：算术类型、枚举和指针按值拷贝，C字符串拷贝内容
+    template <typename T, typename = void>
+    struct ArgCodec {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                      "log arguments must be arithmetic, enum, pointer or C string; use c_str() for std::string");
+        using Decoded = T;
+        static size_t size(const T&) { return sizeof(T); }
+        static uint8_t* encode(uint8_t* ptr, const T& value) {
+            memcpy(ptr, &value, sizeof(T));
+            return ptr + sizeof(T);
+        }
+        static const uint8_t* decode(const uint8_t* ptr, T& value) {
+            memcpy(&value, ptr, sizeof(T));
+            return ptr + sizeof(T);
+        }
+    };
+
+    struct StringCodec {
+        using Decoded = const char*;
+        static size_t size(const char* str) { return sizeof(uint32_t) + (str ? strlen(str) : 6) + 1; }
+        static uint8_t* encode(uint8_t* ptr, const char* str) {
+            if (!str) str = "(null)";
+            uint32_t len = (uint32_t)strlen(str);
+            memcpy(ptr, &len, sizeof(len));
+            memcpy(ptr + sizeof(len), str, len + 1);
+            return ptr + sizeof(len) + len + 1;
+        }
+        static const uint8_t* decode(const uint8_t* ptr, const char*& str) {
+            uint32_t len;
+            memcpy(&len, ptr, sizeof(len));
+            str = (const char*)ptr + sizeof(len);
+            return ptr + sizeof(len) + len + 1;
+        }
+    };
+
+    template <typename T>
+    struct ArgCodec<T, typename std::enable_if<std::is_same<T, const char*>::value || std::is_same<T, char*>::value>::type>
+        : StringCodec {};
+
+    static size_t argsSize() { return 0; }
+
+    template <typename T, typename... Rest>
+    static size_t argsSize(const T& value, const Rest&... rest) {
+        using Codec = ArgCodec<typename std::decay<T>::type>;
+        return Codec::size(value) + argsSize(rest...);
+    }
+
+    static void encodeArgs(uint8_t*) {}
+
+    template <typename T, typename... Rest>
+    static void encodeArgs(uint8_t* ptr, const T& value, const Rest&... rest) {
+        using Codec = ArgCodec<typename std::decay<T>::type>;
+        encodeArgs(Codec::encode(ptr, value), rest...);
+    }
+
+    template <typename Tuple, size_t... I>
+    static void decodeArgs(const uint8_t* ptr, Tuple& args, std::index_sequence<I...>) {
+        using Expand = int[];
+        (void)Expand{0, (ptr = ArgCodec<typename std::tuple_element<I, Tuple>::type, void>::decode(ptr, std::get<I>(args)), 0)...};
+    }
+
+    template <typename... Args>
+    static void formatArgs(const char* fmt, const uint8_t* ptr, std::string& out) {
+        if constexpr (sizeof...(Args) == 0) {
+            out.append(fmt);
+            return;
+        } else {
+            std::tuple<typename ArgCodec<Args>::Decoded...> args;
+            decodeArgs(ptr, args, std::index_sequence_for<Args...>());
+            std::apply([&](const auto&... values) {
+                char buf[1024];
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+                int n = snprintf(buf, sizeof(buf), fmt, values...);
+                if (n >= (int)sizeof(buf)) {
+                    std::string big(n + 1, '\0');
+                    snprintf(&big[0], big.size(), fmt, values...);
+                    out.append(big.data(), n);
+                    return;
+                }
+#pragma GCC diagnostic pop
+                if (n > 0) out.append(buf, n);
+            }, args);
+        }
+    }
+
+    static std::atomic<int>& levelRef() {
+        static std::atomic<int> level{LOG_ACTIVE_LEVEL};
+        return level;
+    }
+
+    // 故意不析构，保证其他静态对象析构期间仍可写日志；进程退出时由atexit写出剩余日志
+    static Logger& Instance() {
+        static Logger* instance = new Logger();
+        return *instance;
+    }
+
+    static ThreadBuffer& threadBuffer() {
+        thread_local ThreadBufferHolder holder;
+        if (!holder.buffer) {
+            holder.buffer = std::make_shared<ThreadBuffer>();
+            holder.buffer->tid = (uint32_t)syscall(SYS_gettid);
+            Instance().addBuffer(holder.buffer);
+        }
+        return *holder.buffer;
+    }
+
+    Logger() {
+        _thread = std::thread([this]() { run(); });
+        std::atexit([]() { Instance().stop(); });
+    }
+
+    void addBuffer(const std::shared_ptr<ThreadBuffer>& buffer) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.push_back(buffer);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_exit) {
+            _cond.wait_for(lock, std::chrono::milliseconds(20));
+            lock.unlock();
+            flushAll();
+            lock.lock();
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_exit) return;
+            _exit = true;
+        }
+        _cond.notify_one();
+        if (_thread.joinable()) _thread.join();
+        flushAll();
+    }
+
+    void flushAll() {
+        std::lock_guard<std::mutex> flush_lock(_flush_mutex);
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        FILE* out;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            buffers = _buffers;
+            out = _out;
+        }
+
+        _lines.clear();
+        for (auto& buffer : buffers) {
+            buffer->consume([&](const uint8_t* ptr) {
+                Record record;
+                memcpy(&record, ptr, sizeof(record));
+                _lines.emplace_back(record.time_ns, std::string());
+                formatRecord(record, ptr + sizeof(Record), _lines.back().second);
+            });
+            uint64_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped) {
+                char msg[96];
+                snprintf(msg, sizeof(msg), "[logger] thread %u dropped %llu records\n", buffer->tid, (unsigned long long)dropped);
+                _lines.emplace_back(0, msg);
+            }
+        }
+        if (_lines.empty()) {
+            removeRetired();
+            return;
+        }
+
+        std::stable_sort(_lines.begin(), _lines.end(),
+                         [](const std::pair<int64_t, std::string>& a, const std::pair<int64_t, std::string>& b) {
+                             return a.first < b.first;
+                         });
+        for (auto& line : _lines) {
+            fwrite(line.second.data(), 1, line.second.size(), out);
+        }
+        fflush(out);
+        removeRetired();
+    }
+
+    void removeRetired() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.erase(std::remove_if(_buffers.begin(), _buffers.end(), [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            return buffer->retired && buffer->empty();
+        }), _buffers.end());
+    }
+
+    static void formatRecord(const Record& record, const uint8_t* args, std::string& out) {
+        static const char* kLevelName[] = {"T", "D", "I", "W", "E"};
+        time_t sec = record.time_ns / 1000000000;
+        int ms = (int)(record.time_ns / 1000000 % 1000);
+        struct tm tm;
+        localtime_r(&sec, &tm);
+
+        const char* file = strrchr(record.file, '/');
+        file = file ? file + 1 : record.file;
+
+        char head[128];
+        int n = snprintf(head, sizeof(head), "%04d-%02d-%02d %02d:%02d:%02d.%03d %s %u %s:%u | ",
+                         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, ms,
+                         kLevelName[record.level < LNone ? record.level : (int)LError], record.tid, file, record.line);
+        out.append(head, n > 0 ? std::min<size_t>(n, sizeof(head) - 1) : 0);
+        record.format(record.fmt, args, out);
+        out.push_back('\n');
+    }
+
+private:
+    std::mutex _mutex;
+    std::mutex _flush_mutex;
+    std::condition_variable _cond;
+    bool _exit = false;
+    FILE* _out = stderr;
+    std::thread _thread;
+    std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+    // 只在写出时使用，复用内存
+    std::vector<std::pair<int64_t, std::string>> _lines;
+};
+
+/**
+ * 日志限频，用于会话内反复出现的同类错误
+ * 每个interval_ms内只放行一条，并报告期间被抑制的条数
+ */
+class LogLimiter {
+public:
+    explicit LogLimiter(uint64_t interval_ms = 5000) : _interval_ms(interval_ms) {}
+
+    bool allow(uint32_t& suppressed) {
+        uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (_last_ms && now - _last_ms < _interval_ms) {
+            ++_suppressed;
+            return false;
+        }
+        _last_ms = now;
+        suppressed = _suppressed;
+        _suppressed = 0;
+        return true;
+    }
+
+private:
+    uint64_t _interval_ms;
+    uint64_t _last_ms = 0;
+    uint32_t _suppressed = 0;
+};
+
+} // namespace toolkit
+
+#define LOG_WRITE(level, fmt, ...)                                                                     \
+    do {                                                                                               \
+        if (toolkit::Logger::enabled(level)) {                                                         \
+            if (0) toolkit::Logger::checkFormat(fmt, ##__VA_ARGS__);                                  \
+            toolkit::Logger::write(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__);                     \
+        }                                                                                              \
+    } while (0)
+
+#define LOG_LIMIT(limiter, level, fmt, ...)                                                            \
+    do {                                                                                               \
+        uint32_t _log_suppressed = 0;                                                                  \
+        if (toolkit::Logger::enabled(level) && (limiter).allow(_log_suppressed)) {                     \
+            if (0) toolkit::Logger::checkFormat(fmt, ##__VA_ARGS__);                                  \
+            if (_log_suppressed)                                                                       \
+                toolkit::Logger::write(level, __FILE__, __LINE__, fmt " (%u similar suppressed)",     \
+                                       ##__VA_ARGS__, _log_suppressed);                                \
+            else                                                                                       \
+                toolkit::Logger::write(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__);                 \
+        }                                                                                              \
+    } while (0)
+
+#if LOG_ACTIVE_LEVEL <= 0
+#define TraceL(fmt, ...) LOG_WRITE(toolkit::LTrace, fmt, ##__VA_ARGS__)
+#else
+#define TraceL(fmt, ...) ((void)0)
+#endif
+
+#if LOG_ACTIVE_LEVEL <= 1
+#define DebugL(fmt, ...) LOG_WRITE(toolkit::LDebug, fmt, ##__VA_ARGS__)
+#else
+#define DebugL(fmt, ...) ((void)0)
+#endif
+
+#define InfoL(fmt, ...) LOG_WRITE(toolkit::LInfo, fmt, ##__VA_ARGS__)
+#define WarnL(fmt, ...) LOG_WRITE(toolkit::LWarn, fmt, ##__VA_ARGS__)
+#define ErrorL(fmt, ...) LOG_WRITE(toolkit::LError, fmt, ##__VA_ARGS__)
+
+// 限频版本，limiter为会话持有的LogLimiter
+#define WarnLimit(limiter, fmt, ...) LOG_LIMIT(limiter, toolkit::LWarn, fmt, ##__VA_ARGS__)
+#define ErrorLimit(limiter, fmt, ...) LOG_LIMIT(limiter, toolkit::LError, fmt, ##__VA_ARGS__)
@@ -0,0 +1,158 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+namespace toolkit {
+
+/**
+ * 变长记录环，单写多读、读路径无锁；TimeShiftBuffer（文件映射）和ShmRing（跨进程共享内存）共用
+ * 1. 记录 = Header + 数据，按8字节对齐顺序追加；环尾放不下一条记录时写一个回绕标记（放不下头部时省略），从头继续
+ * 2. head/tail是累计写入字节数（逻辑位置），写者在覆盖一段数据之前先推进tail，
+ *    读者读完后检查自己的位置是否仍不小于tail（seqlock方式），发现被覆盖时丢弃
+ * 数据区和head/tail由使用者提供，可以在进程内存或共享内存中；本类只保存指针，可随意拷贝
+ * Header需要有uint32_t size和整数flags两个字段，flags的kFlagWrap位保留给回绕标记
+ */
+template <typename Header>
+class RecordRing {
+public:
+    static constexpr uint32_t kFlagWrap = 0x80;
+
+    /**
+     * 读到的一条记录，data指向环内数据，被写者覆盖后失效（见valid）
+     */
+    struct View {
+        uint64_t pos;
+        Header header;
+        const char* data;
+    };
+
+    enum ReadResult { kRead, kEnd, kLapped };
+
+    RecordRing() = default;
+
+    /**
+     * @param data 数据区，读者可以传入只读映射，读路径不会写入
+     * @param capacity 数据区大小，8的倍数
+     */
+    RecordRing(char* data, uint64_t capacity, std::atomic<uint64_t>* head, std::atomic<uint64_t>* tail)
+        : _data(data), _capacity(capacity), _head(head), _tail(tail) {}
+
+    uint64_t capacity() const { return _capacity; }
+    uint64_t head() const { return _head->load(std::memory_order_acquire); }
+    uint64_t tail() const { return _tail->load(std::memory_order_acquire); }
+
+    static uint64_t recordSize(uint64_t size) { return align8(sizeof(Header) + size); }
+
+    /**
+     * 追加一条记录并发布，只能在单一线程调用
+     * @param header 除size外由调用者填写
+     * @param pieces 数据由多段拼接后连续存放，读者看到的是一整块
+     * @param pos 返回记录的逻辑位置
+     * @return 记录超过数据区的1/4时丢弃并返回false
+     */
+    bool append(Header header, std::initializer_list<std::pair<const char*, size_t>> pieces, uint64_t& pos) {
+        uint64_t size = 0;
+        for (auto& piece : pieces) size += piece.second;
+        uint64_t len = recordSize(size);
+        if (len > _capacity / 4) return false;
+
+        pos = _head->load(std::memory_order_relaxed);
+        uint64_t off = pos % _capacity;
+        uint64_t skip = off + len > _capacity ? _capacity - off : 0;
+
+        // 先让读者看到即将被覆盖的范围，再改写数据
+        advanceTail(pos + skip + len);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        if (skip >= sizeof(Header)) {
+            Header wrap{};
+            wrap.flags = kFlagWrap;
+            memcpy(_data + off, &wrap, sizeof(wrap));
+        }
+        pos += skip;
+        off = pos % _capacity;
+
+        header.size = (uint32_t)size;
+        header.flags &= ~kFlagWrap;
+        memcpy(_data + off, &header, sizeof(header));
+        char* dst = _data + off + sizeof(header);
+        for (auto& piece : pieces) {
+            memcpy(dst, piece.first, piece.second);
+            dst += piece.second;
+        }
+        _head->store(pos + len, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 读pos处的记录并把pos推进到下一条，跳过回绕标记
+     * @return kEnd表示已追上写者；kLapped表示pos已被覆盖，调用者应重新定位（如跳到最旧的关键帧）
+     */
+    ReadResult read(uint64_t& pos, View& view) const {
+        for (;;) {
+            if (pos >= _head->load(std::memory_order_acquire)) return kEnd;
+            if (pos < _tail->load(std::memory_order_acquire)) return kLapped;
+
+            uint64_t off = pos % _capacity;
+            if (_capacity - off < sizeof(Header)) {
+                pos += _capacity - off;
+                continue;
+            }
+            memcpy(&view.header, _data + off, sizeof(Header));
+            // 头部可能读到一半被覆盖，校验通过后才能使用
+            if (!valid(pos)) return kLapped;
+            if (view.header.flags & kFlagWrap) {
+                pos += _capacity - off;
+                continue;
+            }
+            view.pos = pos;
+            view.data = _data + off + sizeof(Header);
+            pos += recordSize(view.header.size);
+            return kRead;
+        }
+    }
+
+    /**
+     * 使用完pos处记录的数据之后调用，返回false说明读取期间数据已被覆盖，应丢弃
+     */
+    bool valid(uint64_t pos) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return pos >= _tail->load(std::memory_order_relaxed);
+    }
+
+private:
+    static uint64_t align8(uint64_t n) { return (n + 7) & ~7ULL; }
+
+    // 从pos处的记录跳到下一条记录，只在写线程调用
+    uint64_t nextRecord(uint64_t pos) const {
+        uint64_t off = pos % _capacity;
+        if (_capacity - off < sizeof(Header)) return pos + (_capacity - off);
+        Header header;
+        memcpy(&header, _data + off, sizeof(header));
+        if (header.flags & kFlagWrap) return pos + (_capacity - off);
+        return pos + recordSize(header.size);
+    }
+
+    // 推进tail，使[end - capacity, end)之外的旧数据不再可读
+    void advanceTail(uint64_t end) {
+        if (end <= _capacity) return;
+        uint64_t limit = end - _capacity;
+        uint64_t head = _head->load(std::memory_order_relaxed);
+        uint64_t tail = _tail->load(std::memory_order_relaxed);
+        while (tail < limit && tail < head) {
+            tail = nextRecord(tail);
+        }
+        _tail->store(tail, std::memory_order_relaxed);
+    }
+
+private:
+    char* _data = nullptr;
+    uint64_t _capacity = 0;
+    std::atomic<uint64_t>* _head = nullptr;
+    std::atomic<uint64_t>* _tail = nullptr;
+};
+
+} // namespace toolkit
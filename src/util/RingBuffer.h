@@ -1,41 +1,158 @@
 #pragma once
 #include <memory>
-#include <list>
+#include <deque>
+#include <vector>
 #include <functional>
 #include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include "util/WorkStealingExecutor.h"
+
+/**
+ * 一段连续数据的只读视图，批量分发时指向写入方的数组，只在回调期间有效
+ */
+template <typename T>
+class RingSpan {
+public:
+    RingSpan(const T* data, size_t size) : _data(data), _size(size) {}
+
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+    const T* data() const { return _data; }
+    const T& operator[](size_t i) const { return _data[i]; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+private:
+    const T* _data;
+    size_t _size;
+};
+
+/**
+ * 批量读者接口，每次写入（一次socket读解析出的全部数据）只回调一次onBatch
+ */
+template <typename T>
+class RingReaderBase {
+public:
+    virtual ~RingReaderBase() = default;
+    virtual void onBatch(const RingSpan<T>& batch) = 0;
+};
+
+/**
+ * 静态分发的读者：派生类实现onData(const T&)，逐条调用在编译期确定、可内联，
+ * 每批只有一次虚函数调用，适合热路径上的消费者
+ * 用法: class Foo : public RingReader<Foo, T> { void onData(const T&); };
+ */
+template <typename Derived, typename T>
+class RingReader : public RingReaderBase<T> {
+public:
+    void onBatch(const RingSpan<T>& batch) final {
+        auto self = static_cast<Derived*>(this);
+        for (auto& item : batch) {
+            self->onData(item);
+        }
+    }
+};
+
+/**
+ * 读者订阅模式，用于只需要稀疏数据的消费者（缩略图、移动侦测预筛、抽帧分析等）
+ * 过滤在写入时按帧索引整段进行，不需要的数据不会触发该读者的回调，也不会拷贝或增加引用计数
+ * 帧边界由writeBatch的frame_of给出，间隔按写入时刻（单调时钟）计算
+ */
+struct RingReaderMode {
+    enum Type {
+        All,          // 全部数据
+        KeyFrame,     // 只要关键帧
+        GopInterval,  // 每interval_ms最多一个完整GOP
+        FrameRate     // 帧率上限max_fps；丢弃的非关键帧会使解码中断到下一个关键帧，需要解码的消费者应使用前两种
+    };
+
+    Type type = All;
+    uint32_t interval_ms = 0;
+    double max_fps = 0;
+
+    static RingReaderMode keyFrame() {
+        RingReaderMode mode;
+        mode.type = KeyFrame;
+        return mode;
+    }
+
+    static RingReaderMode gopInterval(uint32_t interval_ms) {
+        RingReaderMode mode;
+        mode.type = GopInterval;
+        mode.interval_ms = interval_ms;
+        return mode;
+    }
+
+    static RingReaderMode frameRate(double max_fps) {
+        RingReaderMode mode;
+        mode.type = FrameRate;
+        mode.max_fps = max_fps;
+        return mode;
+    }
+};
 
 template <typename T>
 class RingBuffer {
 public:
     using Ptr = std::shared_ptr<RingBuffer>;
+    using ReaderId = uint64_t;
+    using Span = RingSpan<T>;
+    using Mode = RingReaderMode;
 
     RingBuffer(size_t max_size = 256, size_t max_gop = 2)
         : _max_size(max_size), _max_gop_size(max_gop) {}
 
     void write(const T& data, bool is_key = false) {
-        std::lock_guard<std::mutex> lock(_mutex);
+        writeBatch(&data, 1, [is_key](const T&) { return is_key; });
+    }
 
-        if (is_key) {
-            _have_key = true;
-            _gop_cache.emplace_back();
+    /**
+     * 批量写入，每条数据视为一帧
+     */
+    template <typename IsKey>
+    void writeBatch(const T* data, size_t size, IsKey&& is_key) {
+        writeBatch(data, size, std::forward<IsKey>(is_key), [this](const T&) { return ++_frame_seq; });
+    }
 
-            while (_gop_cache.size() > _max_gop_size) {
-                _size -= _gop_cache.front().size();
-                _gop_cache.pop_front();
-            }
-        }
+    /**
+     * 批量写入，整批只加一次锁，每个全量读者只回调一次
+     * 写入时建立本批的帧索引（帧起点及该帧是否含关键帧），抽帧读者按索引只收到选中的连续片段
+     * @param is_key 判断单条数据是否为关键帧起点，按值内联调用
+     * @param frame_of 单条数据所属帧的标识（如RTP时间戳），与上一条不同即为新的一帧；
+     *                 SPS/PPS与IDR时间戳相同，因此会和关键帧一起放行
+     */
+    template <typename IsKey, typename FrameOf>
+    void writeBatch(const T* data, size_t size, IsKey&& is_key, FrameOf&& frame_of) {
+        if (size == 0) return;
+        std::lock_guard<std::mutex> lock(_mutex);
 
-        if (_have_key && !_gop_cache.empty()) {
-            _gop_cache.back().push_back(data);
-            _size++;
+        _frames.clear();
+        for (size_t i = 0; i < size; ++i) {
+            bool key = is_key(data[i]);
+            uint64_t frame = (uint64_t)frame_of(data[i]);
+            bool start = !_have_frame || frame != _last_frame;
+            _have_frame = true;
+            _last_frame = frame;
+            // 每批第一条总有一个索引项，接续上一批的帧时标记为cont
+            if (start || i == 0) _frames.push_back(FrameMark{i, false, !start});
+            if (key) _frames.back().key = true;
+            cache(data[i], key, start);
+        }
 
-            while (_size > _max_size && _gop_cache.size() > 1) {
-                _size -= _gop_cache.front().size();
-                _gop_cache.pop_front();
+        Span batch(data, size);
+        if (_on_data) {
+            for (auto& item : batch) _on_data(item);
+        }
+        int64_t now_us = _filtered ? nowUs() : 0;
+        for (auto& reader : _readers) {
+            if (reader.mode.type == Mode::All) {
+                reader.reader->onBatch(batch);
+            } else {
+                dispatchFiltered(reader, data, size, now_us);
             }
         }
-
-        if (_on_data) _on_data(data);
     }
 
     void setOnData(std::function<void(const T&)> cb) {
@@ -44,12 +161,85 @@ public:
 
         // 回放缓存
         for (auto& gop : _gop_cache) {
-            for (auto& pkt : gop) {
+            for (auto& pkt : gop.items) {
                 _on_data(pkt);
             }
         }
     }
 
+    /**
+     * 添加批量读者，与setOnData互不影响，可以同时挂多个消费者
+     * 回调在写线程、持锁状态下执行，回调内不可调用attach/detach
+     * reader由调用方持有，销毁前必须detach（detach会等待进行中的回调结束）
+     * @param reader 读者，通常继承RingReader以静态分发
+     * @param replay 是否先回放GOP缓存，每个GOP回调一次；抽帧读者只回放最新GOP中符合模式的部分
+     * @param mode 订阅模式，默认全部数据
+     * @return 读者ID，用于detach
+     */
+    ReaderId attach(RingReaderBase<T>* reader, bool replay = true, const Mode& mode = Mode()) {
+        return addReader(reader, nullptr, replay, mode);
+    }
+
+    /**
+     * 添加逐条回调的读者，兼容接口，每条数据一次std::function调用
+     */
+    ReaderId attach(std::function<void(const T&)> cb, bool replay = true, const Mode& mode = Mode()) {
+        return addReader(std::unique_ptr<RingReaderBase<T>>(new FunctionReader(std::move(cb))), replay, mode);
+    }
+
+    /**
+     * 添加按批回调的读者，每批一次std::function调用
+     */
+    ReaderId attachBatch(std::function<void(const Span&)> cb, bool replay = true, const Mode& mode = Mode()) {
+        return addReader(std::unique_ptr<RingReaderBase<T>>(new BatchFunctionReader(std::move(cb))), replay, mode);
+    }
+
+    /**
+     * 添加异步读者：写线程把整批数据拷贝后投递到strand，回调在WorkStealingExecutor的worker上按写入顺序执行
+     * 适合耗时的消费者（分析、转码等），不会阻塞收包线程
+     * detach返回时已经在执行的回调可能仍在运行，之后投递的不会再执行
+     * @param cb 数据回调
+     * @param strand 执行队列，多个读者可共用一个strand以保证它们之间的顺序；为空时新建
+     * @param replay 是否先回放GOP缓存
+     * @param mode 订阅模式，只有选中的数据会被拷贝投递
+     */
+    ReaderId attachAsync(std::function<void(const T&)> cb, toolkit::WorkStealingExecutor::Strand::Ptr strand = nullptr,
+                         bool replay = true, const Mode& mode = Mode()) {
+        if (!strand) strand = toolkit::WorkStealingExecutor::Instance().createStrand();
+        std::function<void(int64_t)> observer;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            observer = _async_observer;
+        }
+        return addReader(std::unique_ptr<RingReaderBase<T>>(
+                             new AsyncReader(std::move(cb), std::move(strand), std::move(observer))),
+                         replay, mode);
+    }
+
+    /**
+     * 异步读者的延时观察者：每条数据的回调返回后在worker线程调用，参数为从入队到回调返回的耗时(us)
+     * 写入线程上的分发只包含拷贝入队，异步读者真正的消费延时只能在这里统计
+     * 只对之后attachAsync的读者生效
+     */
+    void setAsyncObserver(std::function<void(int64_t delay_us)> cb) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _async_observer = std::move(cb);
+    }
+
+    void detach(ReaderId id) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _readers.erase(std::remove_if(_readers.begin(), _readers.end(),
+                                      [id](const ReaderItem& item) { return item.id == id; }),
+                       _readers.end());
+        _filtered = std::count_if(_readers.begin(), _readers.end(),
+                                  [](const ReaderItem& item) { return item.mode.type != Mode::All; });
+    }
+
+    size_t readerCount() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _readers.size() + (_on_data ? 1 : 0);
+    }
+
     size_t size() const {
         std::lock_guard<std::mutex> lock(_mutex);
         return _size;
@@ -60,6 +250,203 @@ public:
         _gop_cache.clear();
         _size = 0;
         _have_key = false;
+        _have_frame = false;
+    }
+
+private:
+    class FunctionReader : public RingReader<FunctionReader, T> {
+    public:
+        explicit FunctionReader(std::function<void(const T&)> cb) : _cb(std::move(cb)) {}
+        void onData(const T& data) { _cb(data); }
+
+    private:
+        std::function<void(const T&)> _cb;
+    };
+
+    class BatchFunctionReader : public RingReaderBase<T> {
+    public:
+        explicit BatchFunctionReader(std::function<void(const Span&)> cb) : _cb(std::move(cb)) {}
+        void onBatch(const Span& batch) override { _cb(batch); }
+
+    private:
+        std::function<void(const Span&)> _cb;
+    };
+
+    class AsyncReader : public RingReaderBase<T> {
+    public:
+        AsyncReader(std::function<void(const T&)> cb, toolkit::WorkStealingExecutor::Strand::Ptr strand,
+                    std::function<void(int64_t)> observer)
+            : _cb(std::make_shared<std::function<void(const T&)>>(std::move(cb))), _strand(std::move(strand)),
+              _observer(std::move(observer)) {}
+
+        void onBatch(const Span& batch) override {
+            // _cb只由本读者持有，detach后已投递未执行的任务自动失效
+            std::weak_ptr<std::function<void(const T&)>> weak_cb = _cb;
+            std::vector<T> items(batch.begin(), batch.end());
+            if (!_observer) {
+                _strand->post([weak_cb, items]() {
+                    auto cb = weak_cb.lock();
+                    if (!cb) return;
+                    for (auto& item : items) (*cb)(item);
+                });
+                return;
+            }
+            auto observer = _observer;
+            int64_t posted_us = nowUs();
+            _strand->post([weak_cb, items, observer, posted_us]() {
+                auto cb = weak_cb.lock();
+                if (!cb) return;
+                for (auto& item : items) {
+                    (*cb)(item);
+                    observer(nowUs() - posted_us);
+                }
+            });
+        }
+
+    private:
+        std::shared_ptr<std::function<void(const T&)>> _cb;
+        toolkit::WorkStealingExecutor::Strand::Ptr _strand;
+        std::function<void(int64_t)> _observer;
+    };
+
+    struct ReaderItem {
+        ReaderId id;
+        RingReaderBase<T>* reader;
+        std::unique_ptr<RingReaderBase<T>> owned;
+        Mode mode;
+        // 抽帧状态：当前帧是否放行、是否已从关键帧开始、上次放行时刻(us)
+        bool passing = false;
+        bool started = false;
+        int64_t last_us = 0;
+    };
+
+    // 本批中一帧的起点，cont表示接续上一批未结束的帧
+    struct FrameMark {
+        size_t index;
+        bool key;
+        bool cont;
+    };
+
+    // GOP缓存，key_end为关键帧之后第一帧的起点，0表示关键帧尚未结束
+    struct Gop {
+        std::vector<T> items;
+        size_t key_end = 0;
+    };
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ReaderId addReader(std::unique_ptr<RingReaderBase<T>> owned, bool replay, const Mode& mode) {
+        auto reader = owned.get();
+        return addReader(reader, std::move(owned), replay, mode);
+    }
+
+    ReaderId addReader(RingReaderBase<T>* reader, std::unique_ptr<RingReaderBase<T>> owned, bool replay,
+                       const Mode& mode) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ReaderItem item{++_reader_id, reader, std::move(owned), mode};
+        if (mode.type == Mode::All) {
+            if (replay) {
+                for (auto& gop : _gop_cache) {
+                    if (!gop.items.empty()) reader->onBatch(Span(gop.items.data(), gop.items.size()));
+                }
+            }
+        } else {
+            ++_filtered;
+            if (replay && !_gop_cache.empty() && !_gop_cache.back().items.empty()) {
+                // 只回放最新GOP：GOP模式回放整个GOP并继续接收，其余模式只回放关键帧
+                auto& gop = _gop_cache.back();
+                bool whole = mode.type == Mode::GopInterval || gop.key_end == 0;
+                size_t len = whole ? gop.items.size() : gop.key_end;
+                reader->onBatch(Span(gop.items.data(), len));
+                item.passing = whole;
+                item.started = true;
+                item.last_us = nowUs();
+            }
+        }
+        ReaderId id = item.id;
+        _readers.push_back(std::move(item));
+        return id;
+    }
+
+    // 持锁调用，按本批帧索引决定每帧是否放行，连续放行的帧合并为一次回调
+    void dispatchFiltered(ReaderItem& reader, const T* data, size_t size, int64_t now_us) {
+        size_t run_begin = 0;
+        for (auto& frame : _frames) {
+            // 只在帧起点决定，接续上一批的帧总是沿用之前的决定，否则已开始放行的关键帧会被截断
+            bool pass = frame.cont ? reader.passing : decide(reader, frame.key, now_us);
+            if (pass == reader.passing) continue;
+            if (reader.passing && frame.index > run_begin) {
+                reader.reader->onBatch(Span(data + run_begin, frame.index - run_begin));
+            }
+            reader.passing = pass;
+            run_begin = frame.index;
+        }
+        if (reader.passing && size > run_begin) {
+            reader.reader->onBatch(Span(data + run_begin, size - run_begin));
+        }
+    }
+
+    // 在一帧起点决定该帧是否放行
+    static bool decide(ReaderItem& reader, bool key, int64_t now_us) {
+        auto& mode = reader.mode;
+        if (!reader.started && !key) return false;
+        switch (mode.type) {
+            case Mode::KeyFrame:
+                reader.started = true;
+                return key;
+            case Mode::GopInterval:
+                // 非关键帧跟随所在GOP
+                if (!key) return reader.passing;
+                if (reader.started && now_us - reader.last_us < (int64_t)mode.interval_ms * 1000) return false;
+                break;
+            case Mode::FrameRate: {
+                if (mode.max_fps <= 0) return false;
+                int64_t period = (int64_t)(1000000 / mode.max_fps);
+                if (reader.started && now_us - reader.last_us < period) return false;
+                // 按周期推进而不是取当前时刻，避免帧间隔抖动使实际帧率低于上限
+                if (reader.started && now_us - reader.last_us < 2 * period) {
+                    reader.last_us += period;
+                    return true;
+                }
+                break;
+            }
+            default:
+                return true;
+        }
+        reader.started = true;
+        reader.last_us = now_us;
+        return true;
+    }
+
+    // 持锁调用
+    void cache(const T& data, bool is_key, bool frame_start) {
+        if (frame_start) _frame_has_key = false;
+        // 一帧中只在第一个关键帧起点开始新的GOP，多slice的IDR每个slice都有起点
+        if (is_key && !_frame_has_key) {
+            _frame_has_key = true;
+            _have_key = true;
+            _gop_cache.emplace_back();
+
+            while (_gop_cache.size() > _max_gop_size) {
+                _size -= _gop_cache.front().items.size();
+                _gop_cache.pop_front();
+            }
+        }
+
+        if (_have_key && !_gop_cache.empty()) {
+            auto& gop = _gop_cache.back();
+            if (frame_start && !is_key && gop.key_end == 0) gop.key_end = gop.items.size();
+            gop.items.push_back(data);
+            _size++;
+
+            while (_size > _max_size && _gop_cache.size() > 1) {
+                _size -= _gop_cache.front().items.size();
+                _gop_cache.pop_front();
+            }
+        }
     }
 
 private:
@@ -68,6 +455,19 @@ private:
     size_t _max_gop_size;
     size_t _size = 0;
     bool _have_key = false;
-    std::list<std::list<T>> _gop_cache;
+    bool _frame_has_key = false;
+    // 每个GOP连续存放，回放时整段作为一批分发
+    std::deque<Gop> _gop_cache;
     std::function<void(const T&)> _on_data;
+    std::function<void(int64_t)> _async_observer;
+    ReaderId _reader_id = 0;
+    std::vector<ReaderItem> _readers;
+    // 抽帧读者数量，为0时写入不取时间
+    size_t _filtered = 0;
+    // 本批帧索引，复用容量
+    std::vector<FrameMark> _frames;
+    // 上一条数据的帧标识，跨批延续
+    bool _have_frame = false;
+    uint64_t _last_frame = 0;
+    uint64_t _frame_seq = 0;
 };
@@ -0,0 +1,486 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <cerrno>
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "util/RecordRing.h"
+
+namespace toolkit {
+
+/**
+ * 跨进程共享内存环形缓冲，单写多读、无锁
+ * 段的布局：控制页（ShmRingHeader） | 关键帧索引 | 元数据(SDP等) | 数据区（页对齐）
+ * 1. 数据区按顺序追加变长记录，写满后覆盖最旧的数据，记录布局和覆盖检测见RecordRing
+ * 2. 关键帧索引是定长环形数组，写者改写槽位前先递增key_claim，读者读完一项后据此检查该槽位是否已被复用
+ * 3. 写者每批数据后递增notify并在有等待者时FUTEX_WAKE，读者用FUTEX_WAIT等待，无数据时不轮询
+ * 读者只把控制区映射为可写（登记等待者），数据区只读映射，不会被读者写坏
+ * 段内只使用地址无关的无锁原子量，写者与读者可以是不同进程
+ */
+struct ShmRingHeader {
+    static constexpr uint32_t kMagic = 0x4C535242;  // "LSRB"
+    static constexpr uint32_t kVersion = 2;
+
+    std::atomic<uint32_t> magic;  // 初始化完成后最后写入
+    uint32_t version;
+    uint64_t capacity;            // 数据区大小
+    uint64_t data_offset;
+    uint64_t index_offset;
+    uint64_t meta_offset;
+    uint32_t index_size;          // 关键帧索引容量
+    uint32_t meta_capacity;
+    int32_t writer_pid;
+
+    alignas(64) std::atomic<uint64_t> head;  // 已发布数据的结束位置（累计字节数）
+    std::atomic<uint64_t> tail;              // 最旧的有效记录位置
+    alignas(64) std::atomic<uint64_t> key_count;  // 已发布的关键帧索引项数
+    std::atomic<uint64_t> key_claim;             // 已开始写入的索引项数
+    alignas(64) std::atomic<uint32_t> notify;   // futex字
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> closed;               // 写者已退出
+    alignas(64) std::atomic<uint32_t> meta_seq; // 元数据seqlock，奇数表示正在写
+    uint32_t meta_size;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory atomics must be lock free");
+
+/**
+ * 数据区中每条记录的头部（RecordRing的Header），记录按8字节对齐
+ */
+struct ShmRecordHeader {
+    uint32_t size;
+    uint32_t timestamp;  // RTP时间戳
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t seq;        // 记录序号，读者据此发现被覆盖跳过的记录
+    int64_t wall_us;     // 写入时的unix时间(us)
+};
+static_assert(sizeof(ShmRecordHeader) == 32, "record header must stay 8-byte aligned");
+
+struct ShmKeyEntry {
+    uint64_t pos;
+    uint64_t seq;
+    int64_t wall_us;
+};
+
+namespace shm_detail {
+
+using Records = RecordRing<ShmRecordHeader>;
+
+static constexpr uint32_t kFlagKey = 1;
+
+inline uint64_t alignPage(uint64_t n) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    return (n + page - 1) / page * page;
+}
+
+inline long futex(std::atomic<uint32_t>* addr, int op, uint32_t val, const struct timespec* timeout) {
+    return syscall(SYS_futex, (uint32_t*)addr, op, val, timeout, nullptr, 0);
+}
+
+} // namespace shm_detail
+
+/**
+ * 写端，只能在单一线程写入
+ */
+class ShmRingWriter {
+public:
+    ShmRingWriter() = default;
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    ~ShmRingWriter() { close(); }
+
+    /**
+     * 创建共享内存段
+     * @param name POSIX共享内存名（如"/cam1"），同名的旧段会被替换；为空时使用memfd，通过fd()传给读者
+     * @param capacity 数据区大小（字节），按页向上取整
+     * @param index_size 关键帧索引容量
+     * @param meta_capacity 元数据区大小，超出的元数据被截断
+     * @return 失败时返回false，errno为失败原因
+     */
+    bool create(const std::string& name, uint64_t capacity, uint32_t index_size = 1024,
+                uint32_t meta_capacity = 64 * 1024) {
+        close();
+        int fd;
+        if (name.empty()) {
+            fd = memfd_create("lsc-shm-ring", MFD_CLOEXEC);
+        } else {
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        }
+        if (fd < 0) return false;
+
+        index_size = std::max<uint32_t>(index_size, 1);
+        uint64_t index_offset = shm_detail::alignPage(sizeof(ShmRingHeader));
+        uint64_t meta_offset = index_offset + (uint64_t)index_size * sizeof(ShmKeyEntry);
+        uint64_t data_offset = shm_detail::alignPage(meta_offset + meta_capacity);
+        capacity = shm_detail::alignPage(std::max<uint64_t>(capacity, 1));
+        uint64_t total = data_offset + capacity;
+
+        // 预分配，避免写入映射内存时因tmpfs空间不足触发SIGBUS
+        int err = ftruncate(fd, (off_t)total) != 0 ? errno : posix_fallocate(fd, 0, (off_t)total);
+        void* base = err ? MAP_FAILED : mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            if (!err) err = errno;
+            ::close(fd);
+            if (!name.empty()) shm_unlink(name.c_str());
+            errno = err;
+            return false;
+        }
+
+        _fd = fd;
+        _name = name;
+        _base = (char*)base;
+        _size = total;
+        _hdr = (ShmRingHeader*)base;
+        _keys = (ShmKeyEntry*)(_base + index_offset);
+        _meta = _base + meta_offset;
+        _records = shm_detail::Records(_base + data_offset, capacity, &_hdr->head, &_hdr->tail);
+
+        // ftruncate后内容全为0，只需填写非0字段
+        _hdr->version = ShmRingHeader::kVersion;
+        _hdr->capacity = capacity;
+        _hdr->data_offset = data_offset;
+        _hdr->index_offset = index_offset;
+        _hdr->meta_offset = meta_offset;
+        _hdr->index_size = index_size;
+        _hdr->meta_capacity = meta_capacity;
+        _hdr->writer_pid = (int32_t)getpid();
+        _hdr->magic.store(ShmRingHeader::kMagic, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 写者退出：通知读者并删除共享内存名，已映射的读者仍可读完剩余数据
+     */
+    void close() {
+        if (!_base) return;
+        _hdr->closed.store(1, std::memory_order_release);
+        notify();
+        munmap(_base, _size);
+        ::close(_fd);
+        if (!_name.empty()) shm_unlink(_name.c_str());
+        _base = nullptr;
+        _hdr = nullptr;
+        _fd = -1;
+        _name.clear();
+    }
+
+    bool valid() const { return _base != nullptr; }
+    int fd() const { return _fd; }
+    const std::string& name() const { return _name; }
+
+    /**
+     * 设置元数据（如SDP），读者通过ShmRingReader::meta()读取
+     */
+    void setMeta(const std::string& meta) {
+        if (!_base) return;
+        uint32_t len = (uint32_t)std::min<size_t>(meta.size(), _hdr->meta_capacity);
+        uint32_t seq = _hdr->meta_seq.load(std::memory_order_relaxed);
+        _hdr->meta_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(_meta, meta.data(), len);
+        _hdr->meta_size = len;
+        _hdr->meta_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * 追加一条记录，数据由多段拼接后连续存放，读者看到的是一整块
+     * 写入后读者即可读到，但需要notify()才会唤醒等待的读者
+     * @return 记录超过数据区的1/4时丢弃并返回false
+     */
+    bool write(uint32_t timestamp, bool key, int64_t wall_us,
+               std::initializer_list<std::pair<const char*, size_t>> pieces) {
+        if (!_base) return false;
+        ShmRecordHeader header{};
+        header.timestamp = timestamp;
+        header.flags = key ? shm_detail::kFlagKey : 0;
+        header.seq = _seq;
+        header.wall_us = wall_us;
+        uint64_t pos;
+        if (!_records.append(header, pieces, pos)) return false;
+        ++_seq;
+
+        if (key) {
+            // 先登记再改写槽位，最后发布计数；读者读完槽位后看到登记即知道该槽位可能已被改写
+            uint64_t count = _hdr->key_count.load(std::memory_order_relaxed);
+            _hdr->key_claim.store(count + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _keys[count % _hdr->index_size] = ShmKeyEntry{pos, header.seq, wall_us};
+            _hdr->key_count.store(count + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /**
+     * 唤醒等待的读者，每批写入后调用一次；没有读者在等待时不进入内核
+     */
+    void notify() {
+        if (!_base) return;
+        _hdr->notify.fetch_add(1, std::memory_order_seq_cst);
+        if (_hdr->waiters.load(std::memory_order_seq_cst) > 0) {
+            shm_detail::futex(&_hdr->notify, FUTEX_WAKE, INT_MAX, nullptr);
+        }
+    }
+
+    uint64_t capacity() const { return _base ? _hdr->capacity : 0; }
+
+private:
+    int _fd = -1;
+    std::string _name;
+    char* _base = nullptr;
+    uint64_t _size = 0;
+    ShmRingHeader* _hdr = nullptr;
+    ShmKeyEntry* _keys = nullptr;
+    char* _meta = nullptr;
+    shm_detail::Records _records;
+    uint64_t _seq = 0;
+};
+
+/**
+ * 读端，可在其他进程使用，只依赖本头文件
+ * 每个读者有自己的游标，互不影响，也不会阻塞写者；读得比写慢一整圈时跳到最旧的关键帧，lapped()计数加一
+ */
+class ShmRingReader {
+public:
+    /**
+     * 读到的一条记录，data指向共享内存，被写者覆盖后失效（见valid）
+     */
+    struct Record {
+        uint64_t pos = 0;
+        uint64_t seq = 0;
+        uint32_t timestamp = 0;
+        bool key = false;
+        int64_t wall_us = 0;
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    ShmRingReader() = default;
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    ~ShmRingReader() { close(); }
+
+    /**
+     * 按POSIX共享内存名打开，打开后定位到最新的关键帧
+     */
+    bool open(const std::string& name) {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) return false;
+        bool ret = attach(fd);
+        ::close(fd);
+        return ret;
+    }
+
+    /**
+     * 通过写者的memfd（SCM_RIGHTS传递或/proc/<pid>/fd/<n>打开）映射，不接管fd
+     */
+    bool attach(int fd) {
+        close();
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(ShmRingHeader)) return false;
+        uint64_t total = (uint64_t)st.st_size;
+
+        // 控制区可写（登记等待者），数据区只读
+        ShmRingHeader probe;
+        if (pread(fd, &probe, sizeof(probe), 0) != (ssize_t)sizeof(probe)) return false;
+        if (probe.magic.load(std::memory_order_relaxed) != ShmRingHeader::kMagic ||
+            probe.version != ShmRingHeader::kVersion || probe.data_offset + probe.capacity > total) {
+            errno = EINVAL;
+            return false;
+        }
+        void* ctrl = mmap(nullptr, probe.data_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ctrl == MAP_FAILED) return false;
+        void* data = mmap(nullptr, probe.capacity, PROT_READ, MAP_SHARED, fd, (off_t)probe.data_offset);
+        if (data == MAP_FAILED) {
+            munmap(ctrl, probe.data_offset);
+            return false;
+        }
+
+        _ctrl = (char*)ctrl;
+        _ctrl_size = probe.data_offset;
+        _data = data;
+        _hdr = (ShmRingHeader*)ctrl;
+        _capacity = probe.capacity;
+        // 只读映射，读路径不写数据区
+        _records = shm_detail::Records((char*)data, probe.capacity, &_hdr->head, &_hdr->tail);
+        _keys = (const ShmKeyEntry*)(_ctrl + probe.index_offset);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!seekLatest()) _pos = _hdr->head.load(std::memory_order_acquire);
+        return true;
+    }
+
+    void close() {
+        if (!_ctrl) return;
+        munmap(_ctrl, _ctrl_size);
+        munmap(_data, _capacity);
+        _ctrl = nullptr;
+        _data = nullptr;
+        _hdr = nullptr;
+    }
+
+    bool valid() const { return _ctrl != nullptr; }
+
+    /**
+     * 写者已退出，读完剩余数据后应关闭，必要时重新open
+     */
+    bool closed() const { return !_hdr || _hdr->closed.load(std::memory_order_acquire); }
+
+    int writerPid() const { return _hdr ? _hdr->writer_pid : 0; }
+
+    /**
+     * 写者设置的元数据（如SDP）
+     */
+    std::string meta() const {
+        if (!_hdr) return "";
+        for (;;) {
+            uint32_t seq = _hdr->meta_seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            uint32_t len = std::min(_hdr->meta_size, _hdr->meta_capacity);
+            std::string ret(_ctrl + _hdr->meta_offset, len);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_hdr->meta_seq.load(std::memory_order_relaxed) == seq) return ret;
+        }
+    }
+
+    /**
+     * 定位到最新/最旧的关键帧，或不晚于wall_us的最后一个关键帧
+     * @return 缓冲中还没有关键帧时返回false
+     */
+    bool seekLatest() { return findKey(INT64_MAX); }
+    bool seekOldest() { return findKey(INT64_MIN); }
+    bool seekTime(int64_t wall_us) { return findKey(wall_us); }
+
+    /**
+     * 跳到最新位置，只读之后写入的记录
+     */
+    void seekHead() {
+        if (_hdr) _pos = _hdr->head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * 读下一条记录
+     * @return 已追上写者时返回false，可以wait后继续调用
+     */
+    bool next(Record& rec) {
+        if (!_hdr) return false;
+        shm_detail::Records::View view;
+        for (;;) {
+            auto ret = _records.read(_pos, view);
+            if (ret == shm_detail::Records::kEnd) return false;
+            if (ret == shm_detail::Records::kRead) break;
+            ++_lapped;
+            if (!seekOldest()) return false;
+        }
+        rec.pos = view.pos;
+        rec.seq = view.header.seq;
+        rec.timestamp = view.header.timestamp;
+        rec.key = (view.header.flags & shm_detail::kFlagKey) != 0;
+        rec.wall_us = view.header.wall_us;
+        rec.data = view.data;
+        rec.size = view.header.size;
+        return true;
+    }
+
+    /**
+     * 使用完rec.data之后调用，返回false说明读取期间数据已被覆盖，应丢弃
+     */
+    bool valid(const Record& rec) const { return valid(rec.pos); }
+
+    /**
+     * 等待新数据
+     * @param timeout_ms 超时（毫秒），-1表示一直等待
+     * @return 有数据可读时返回true；超时或写者已退出时返回false
+     */
+    bool wait(int timeout_ms = -1) {
+        if (!_hdr) return false;
+        if (available()) return true;
+        // 先登记等待者再读取notify：写者要么看到等待者而唤醒，要么其递增已被这里读到
+        _hdr->waiters.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t seq = _hdr->notify.load(std::memory_order_seq_cst);
+        if (!available() && !closed()) {
+            struct timespec ts;
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+            shm_detail::futex(&_hdr->notify, FUTEX_WAIT, seq, timeout_ms < 0 ? nullptr : &ts);
+        }
+        _hdr->waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return available();
+    }
+
+    bool available() const { return _hdr && _pos < _hdr->head.load(std::memory_order_acquire); }
+
+    uint64_t position() const { return _pos; }
+    uint64_t lapped() const { return _lapped; }
+
+private:
+    bool valid(uint64_t pos) const { return _records.valid(pos); }
+
+    // 读取第i个关键帧索引项，槽位已被复用或数据已被覆盖时返回false
+    bool keyAt(uint64_t i, ShmKeyEntry& entry) const {
+        uint32_t n = _hdr->index_size;
+        memcpy(&entry, &_keys[i % n], sizeof(entry));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // 第i + n项会复用这个槽位
+        return _hdr->key_claim.load(std::memory_order_relaxed) <= i + n && valid(entry.pos);
+    }
+
+    // 定位到最后一个不晚于target的有效关键帧，早于所有有效关键帧时定位到最旧的
+    bool findKey(int64_t target) {
+        if (!_hdr) return false;
+        for (;;) {
+            uint64_t count = _hdr->key_count.load(std::memory_order_acquire);
+            if (count == 0) return false;
+            uint32_t n = _hdr->index_size;
+            uint64_t first = count > n ? count - n : 0;
+            // 跳过已失效的项：失效只会从旧到新发生，二分找到第一个有效项
+            uint64_t lo = first, hi = count;
+            ShmKeyEntry entry;
+            while (lo < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                if (keyAt(mid, entry)) hi = mid;
+                else lo = mid + 1;
+            }
+            if (lo == count) return false;
+
+            uint64_t valid_first = lo;
+            hi = count;
+            while (lo < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                if (!keyAt(mid, entry)) break;
+                if (entry.wall_us <= target) lo = mid + 1;
+                else hi = mid;
+            }
+            if (lo < hi) continue;  // 查找期间索引被改写，重试
+            if (!keyAt(lo > valid_first ? lo - 1 : valid_first, entry)) continue;
+            _pos = entry.pos;
+            return true;
+        }
+    }
+
+private:
+    char* _ctrl = nullptr;
+    uint64_t _ctrl_size = 0;
+    void* _data = nullptr;
+    uint64_t _capacity = 0;
+    shm_detail::Records _records;
+    ShmRingHeader* _hdr = nullptr;
+    const ShmKeyEntry* _keys = nullptr;
+    uint64_t _pos = 0;
+    uint64_t _lapped = 0;
+};
+
+} // namespace toolkit
@@ -7,9 +7,19 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <linux/net_tstamp.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <functional>
+
+// Linux 5.11引入，旧的libc头文件中可能没有
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
 
 namespace toolkit {
 
@@ -28,7 +38,15 @@ public:
         if (!getDomainIP(host, port, addr)) {
             return -1;
         }
+        return connect(addr, async);
+    }
 
+    /**
+     * 连接已解析的地址
+     * @param on_socket 创建socket后、connect之前回调，设置需要在SYN之前生效的选项（如SO_RCVBUF）
+     */
+    static int connect(const sockaddr_storage& addr, bool async = true,
+                       const std::function<void(int fd)>& on_socket = nullptr) {
         int sockfd = socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
         if (sockfd < 0) {
             return -1;
@@ -38,6 +56,7 @@ public:
         setNoBlocked(sockfd, async);
         setNoDelay(sockfd);
         setCloExec(sockfd);
+        if (on_socket) on_socket(sockfd);
 
         if (::connect(sockfd, (sockaddr*)&addr, getSockLen((sockaddr*)&addr)) == 0) {
             return sockfd;
@@ -52,17 +71,88 @@ public:
     }
 
     /**
-     * DNS解析
+     * 创建TCP监听socket
+     * @param port 监听端口
+     * @param local_ip 绑定的本地IP
+     * @param backlog 监听队列长度
+     * @return socket fd，失败返回-1
      */
-    static bool getDomainIP(const char* host, uint16_t port, sockaddr_storage& addr) {
-        memset(&addr, 0, sizeof(addr));
+    static int listen(uint16_t port, const char* local_ip = "0.0.0.0", int backlog = 1024) {
+        sockaddr_storage addr;
+        if (!getDomainIP(local_ip, port, addr)) {
+            return -1;
+        }
 
-        // 先尝试直接解析IP
-        auto* addr4 = (sockaddr_in*)&addr;
-        if (inet_pton(AF_INET, host, &addr4->sin_addr) == 1) {
-            addr4->sin_family = AF_INET;
-            addr4->sin_port = htons(port);
-            return true;
+        int sockfd = socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (sockfd < 0) {
+            return -1;
+        }
+
+        setReuseable(sockfd);
+        setNoBlocked(sockfd);
+        setCloExec(sockfd);
+
+        if (::bind(sockfd, (sockaddr*)&addr, getSockLen((sockaddr*)&addr)) < 0 ||
+            ::listen(sockfd, backlog) < 0) {
+            ::close(sockfd);
+            return -1;
+        }
+        return sockfd;
+    }
+
+    /**
+     * 创建UDP socket并绑定
+     * @param port 本地端口，0表示随机端口
+     * @param local_ip 绑定的本地IP
+     * @return socket fd，失败返回-1
+     */
+    static int bindUdpSock(uint16_t port, const char* local_ip = "0.0.0.0") {
+        sockaddr_storage addr;
+        if (!getDomainIP(local_ip, port, addr)) {
+            return -1;
+        }
+
+        int sockfd = socket(addr.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        if (sockfd < 0) {
+            return -1;
+        }
+
+        setReuseable(sockfd);
+        setNoBlocked(sockfd);
+        setCloExec(sockfd);
+
+        if (::bind(sockfd, (sockaddr*)&addr, getSockLen((sockaddr*)&addr)) < 0) {
+            ::close(sockfd);
+            return -1;
+        }
+        return sockfd;
+    }
+
+    /**
+     * 获取socket绑定的本地端口
+     */
+    static uint16_t getLocalPort(int fd) {
+        sockaddr_storage addr{};
+        socklen_t len = sizeof(addr);
+        if (getsockname(fd, (sockaddr*)&addr, &len) < 0) {
+            return 0;
+        }
+        if (addr.ss_family == AF_INET6) {
+            return ntohs(((sockaddr_in6*)&addr)->sin6_port);
+        }
+        return ntohs(((sockaddr_in*)&addr)->sin_port);
+    }
+
+    /**
+     * DNS解析，成功结果缓存dns_cache_sec秒，避免大量连接同时解析同一个域名；
+     * 失败结果缓存dns_fail_sec秒，DNS故障期间重连不会每次都阻塞在getaddrinfo上
+     * 会阻塞调用线程，I/O loop上应使用DnsResolver
+     */
+    static bool getDomainIP(const char* host, uint16_t port, sockaddr_storage& addr,
+                            int dns_cache_sec = 60, int dns_fail_sec = 5) {
+        bool failed = false;
+        if (getDomainIPCached(host, port, addr, failed, dns_cache_sec, dns_fail_sec)) {
+            return !failed;
         }
 
         // DNS解析
@@ -71,15 +161,50 @@ public:
         hints.ai_socktype = SOCK_STREAM;
 
         if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+            if (dns_fail_sec > 0) setDnsCache(host, nullptr);
             return false;
         }
 
         memcpy(&addr, result->ai_addr, result->ai_addrlen);
-        ((sockaddr_in*)&addr)->sin_port = htons(port);
+        setPort(addr, port);
         freeaddrinfo(result);
+        if (dns_cache_sec > 0) setDnsCache(host, &addr);
         return true;
     }
 
+    /**
+     * 只解析IP字面量和查缓存，不阻塞
+     * @param failed 命中失败缓存时为true
+     * @return 是否得到结果（成功或近期已失败）
+     */
+    static bool getDomainIPCached(const char* host, uint16_t port, sockaddr_storage& addr, bool& failed,
+                                  int dns_cache_sec = 60, int dns_fail_sec = 5) {
+        memset(&addr, 0, sizeof(addr));
+        failed = false;
+
+        // 先尝试直接解析IP
+        auto* addr4 = (sockaddr_in*)&addr;
+        if (inet_pton(AF_INET, host, &addr4->sin_addr) == 1) {
+            addr4->sin_family = AF_INET;
+            addr4->sin_port = htons(port);
+            return true;
+        }
+
+        if (getDnsCache(host, dns_cache_sec, dns_fail_sec, addr, failed)) {
+            if (!failed) setPort(addr, port);
+            return true;
+        }
+        return false;
+    }
+
+    static void setPort(sockaddr_storage& addr, uint16_t port) {
+        if (addr.ss_family == AF_INET6) {
+            ((sockaddr_in6*)&addr)->sin6_port = htons(port);
+        } else {
+            ((sockaddr_in*)&addr)->sin_port = htons(port);
+        }
+    }
+
     /**
      * 设置非阻塞
      */
@@ -124,6 +249,119 @@ public:
         return fcntl(fd, F_SETFD, flags);
     }
 
+    /**
+     * 获取处理该socket收包的CPU（SO_INCOMING_CPU），失败返回-1
+     */
+    static int getIncomingCpu(int fd) {
+#ifdef SO_INCOMING_CPU
+        int cpu = -1;
+        socklen_t len = sizeof(cpu);
+        if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0) {
+            return cpu;
+        }
+#endif
+        return -1;
+    }
+
+    /**
+     * 开启内核软件接收时间戳(SO_TIMESTAMPING)，与系统时钟同源
+     * 时间戳通过recvmsg的SCM_TIMESTAMPING控制消息返回
+     */
+    static int setRecvTimestamp(int fd, bool enable = true) {
+        int flags = enable ? (SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE) : 0;
+        return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+    }
+
+    /**
+     * 低延时接收选项，只用于少量延时敏感的连接
+     */
+    struct LowLatencyOptions {
+        // SO_BUSY_POLL：阻塞读/epoll时在驱动队列上忙等的微秒数，需要CAP_NET_ADMIN才能超过sysctl上限
+        int busy_poll_us = 50;
+        // SO_PREFER_BUSY_POLL：忙轮询期间抑制网卡中断，让数据只通过忙轮询送达
+        bool prefer_busy_poll = true;
+        // 每次读取后重新开启TCP_QUICKACK，立即回ACK，减少发送端拥塞窗口等待
+        bool quickack = true;
+        // SO_RCVBUF，0表示保持系统默认并由内核自动调整；
+        // 设置后接收缓冲固定为该值（关闭自动调整），窗口扩大因子在SYN时按它确定，过小会限制可用窗口
+        int rcvbuf = 0;
+        // SO_RCVLOWAT，0表示保持系统默认（1字节）
+        int rcvlowat = 0;
+        // SO_INCOMING_CPU，通常为收包loop所在CPU，-1表示不设置
+        int incoming_cpu = -1;
+    };
+
+    /**
+     * 应用低延时选项，不支持的选项忽略
+     * 客户端应在connect之前调用（见connect的on_socket），SO_RCVBUF在握手之后设置不会再改变窗口扩大因子
+     */
+    static void setLowLatency(int fd, const LowLatencyOptions& opt) {
+        if (opt.busy_poll_us > 0) setBusyPoll(fd, opt.busy_poll_us);
+        if (opt.prefer_busy_poll) setPreferBusyPoll(fd);
+        if (opt.quickack) setQuickAck(fd);
+        if (opt.rcvbuf > 0) setRecvBuf(fd, opt.rcvbuf);
+        if (opt.rcvlowat > 0) setRecvLowat(fd, opt.rcvlowat);
+        if (opt.incoming_cpu >= 0) setIncomingCpu(fd, opt.incoming_cpu);
+    }
+
+    static int setBusyPoll(int fd, int usec) {
+#ifdef SO_BUSY_POLL
+        return setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+#else
+        return -1;
+#endif
+    }
+
+    static int setPreferBusyPoll(int fd, bool prefer = true) {
+        int opt = prefer ? 1 : 0;
+        return setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &opt, sizeof(opt));
+    }
+
+    /**
+     * TCP_QUICKACK不是持久选项，内核可能在之后自动退回延迟ACK，需要在每次读取后重新设置
+     */
+    static int setQuickAck(int fd, bool quickack = true) {
+        int opt = quickack ? 1 : 0;
+        return setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+    }
+
+    static int setRecvBuf(int fd, int size) {
+        return setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    static int setRecvLowat(int fd, int bytes) {
+        return setsockopt(fd, SOL_SOCKET, SO_RCVLOWAT, &bytes, sizeof(bytes));
+    }
+
+    static int setIncomingCpu(int fd, int cpu) {
+#ifdef SO_INCOMING_CPU
+        return setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+#else
+        return -1;
+#endif
+    }
+
+    /**
+     * 内核发送限速（字节/秒），TCP自带pacing，UDP需要出口网卡配置fq队列规则才生效
+     */
+    static int setMaxPacingRate(int fd, uint64_t bytes_per_sec) {
+#ifdef SO_MAX_PACING_RATE
+        return setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &bytes_per_sec, sizeof(bytes_per_sec));
+#else
+        return -1;
+#endif
+    }
+
+    /**
+     * close时等待未发送数据的时长（秒），0表示close直接发送RST
+     */
+    static int setCloseWait(int fd, int second = 0) {
+        struct linger lg;
+        lg.l_onoff = 1;
+        lg.l_linger = second;
+        return setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    }
+
     /**
      * 获取socket错误
      */
@@ -182,6 +420,47 @@ public:
         }
         return buf;
     }
+
+private:
+    struct DnsItem {
+        sockaddr_storage addr;
+        bool ok;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    static std::mutex& dnsMutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static std::unordered_map<std::string, DnsItem>& dnsCache() {
+        static std::unordered_map<std::string, DnsItem> cache;
+        return cache;
+    }
+
+    static bool getDnsCache(const char* host, int cache_sec, int fail_sec, sockaddr_storage& addr, bool& failed) {
+        std::lock_guard<std::mutex> lock(dnsMutex());
+        auto it = dnsCache().find(host);
+        if (it == dnsCache().end()) return false;
+        int ttl = it->second.ok ? cache_sec : fail_sec;
+        if (std::chrono::steady_clock::now() - it->second.time > std::chrono::seconds(ttl)) {
+            dnsCache().erase(it);
+            return false;
+        }
+        addr = it->second.addr;
+        failed = !it->second.ok;
+        return true;
+    }
+
+    // addr为空表示解析失败
+    static void setDnsCache(const char* host, const sockaddr_storage* addr) {
+        std::lock_guard<std::mutex> lock(dnsMutex());
+        DnsItem item{};
+        if (addr) item.addr = *addr;
+        item.ok = addr != nullptr;
+        item.time = std::chrono::steady_clock::now();
+        dnsCache()[host] = item;
+    }
 };
 
 } // namespace toolkit
@@ -0,0 +1,134 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace toolkit {
+
+/**
+ * CPU集合，支持"0-3,8,10-11"格式
+ */
+class CpuSet {
+public:
+    CpuSet() = default;
+
+    static CpuSet parse(const std::string& list) {
+        CpuSet set;
+        size_t start = 0;
+        while (start < list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) end = list.size();
+            std::string item = list.substr(start, end - start);
+            size_t dash = item.find('-');
+            if (!item.empty()) {
+                int first = atoi(item.c_str());
+                int last = dash != std::string::npos ? atoi(item.c_str() + dash + 1) : first;
+                for (int cpu = first; cpu <= last; ++cpu) set.add(cpu);
+            }
+            start = end + 1;
+        }
+        return set;
+    }
+
+    /**
+     * 拆分为每个CPU一个集合，用于"每个核一个loop"的配置
+     */
+    std::vector<CpuSet> split() const {
+        std::vector<CpuSet> ret;
+        for (int cpu : _cpus) {
+            CpuSet one;
+            one.add(cpu);
+            ret.push_back(one);
+        }
+        return ret;
+    }
+
+    void add(int cpu) {
+        if (cpu < 0 || contains(cpu)) return;
+        _cpus.insert(std::upper_bound(_cpus.begin(), _cpus.end(), cpu), cpu);
+    }
+
+    bool contains(int cpu) const {
+        return std::binary_search(_cpus.begin(), _cpus.end(), cpu);
+    }
+
+    bool empty() const { return _cpus.empty(); }
+    const std::vector<int>& cpus() const { return _cpus; }
+
+private:
+    std::vector<int> _cpus;
+};
+
+/**
+ * 线程绑核与NUMA内存放置
+ * NUMA策略通过set_mempolicy作用于当前线程，之后该线程新分配的页面
+ * （接收缓冲、RtpPacket、GOP缓存等）优先落在本地节点，不依赖libnuma
+ */
+class ThreadPlacement {
+public:
+    /**
+     * 当前线程绑定到CPU集合
+     */
+    static bool bindCurrentThread(const CpuSet& cpus) {
+        if (cpus.empty()) return false;
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (int cpu : cpus.cpus()) {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &mask);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+    }
+
+    /**
+     * 查询CPU所属NUMA节点，失败返回-1
+     */
+    static int numaNodeOfCpu(int cpu) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+        DIR* dir = opendir(path);
+        if (!dir) return -1;
+        int node = -1;
+        while (struct dirent* ent = readdir(dir)) {
+            if (strncmp(ent->d_name, "node", 4) == 0) {
+                node = atoi(ent->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+        return node;
+    }
+
+    /**
+     * 当前线程的内存分配优先使用指定NUMA节点
+     */
+    static bool preferNode(int node) {
+        static constexpr int kMpolPreferred = 1;
+        if (node < 0 || node >= (int)(sizeof(unsigned long) * 8)) return false;
+        unsigned long mask = 1UL << node;
+        return syscall(SYS_set_mempolicy, kMpolPreferred, &mask, sizeof(mask) * 8) == 0;
+    }
+
+    /**
+     * 绑核，并可选地把内存分配偏好设为第一个CPU所在的NUMA节点
+     * @return 生效的NUMA节点，未设置返回-1
+     */
+    static int apply(const CpuSet& cpus, bool numa_local) {
+        if (cpus.empty()) return -1;
+        bindCurrentThread(cpus);
+        if (!numa_local) return -1;
+        int node = numaNodeOfCpu(cpus.cpus().front());
+        return preferNode(node) ? node : -1;
+    }
+
+    static int currentCpu() { return sched_getcpu(); }
+};
+
+} // namespace toolkit
@@ -0,0 +1,193 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace toolkit {
+
+/**
+ * 分层时间轮（参考Linux内核timer wheel）
+ * 第0层256个槽，每槽一个tick；第1~3层各64个槽，每层粒度放大64倍
+ * 添加/取消都是O(1)，到期前在高层槽之间级联下沉
+ * 非线程安全：add/advance必须在同一线程调用（通常是EventPoller线程），
+ * Timer::cancel()可以在任意线程调用
+ */
+class TimerWheel {
+public:
+    // 返回下次执行的延时(ms)，返回0表示不再执行
+    using Task = std::function<uint64_t()>;
+
+    class Timer {
+    public:
+        using Ptr = std::shared_ptr<Timer>;
+
+        explicit Timer(Task task) : _task(std::move(task)) {}
+
+        /**
+         * 取消定时器，O(1)，节点在到期或级联时被丢弃
+         */
+        void cancel() { _cancelled = true; }
+        bool cancelled() const { return _cancelled; }
+
+    private:
+        friend class TimerWheel;
+        Task _task;
+        uint64_t _expire_tick = 0;
+        std::atomic<bool> _cancelled{false};
+    };
+
+    /**
+     * @param tick_ms 每个tick的毫秒数
+     * @param now_ms 当前时间(ms)
+     */
+    explicit TimerWheel(uint64_t tick_ms = 10, uint64_t now_ms = 0)
+        : _tick_ms(tick_ms ? tick_ms : 1), _now_ms(now_ms), _tick(now_ms / _tick_ms) {}
+
+    /**
+     * 添加定时器
+     * @param timer 定时器节点
+     * @param delay_ms 相对于最近一次advance时间的延时
+     */
+    void add(const Timer::Ptr& timer, uint64_t delay_ms) {
+        timer->_expire_tick = (_now_ms + delay_ms + _tick_ms - 1) / _tick_ms;
+        link(timer);
+    }
+
+    Timer::Ptr add(uint64_t delay_ms, Task task) {
+        auto timer = std::make_shared<Timer>(std::move(task));
+        add(timer, delay_ms);
+        return timer;
+    }
+
+    /**
+     * 推进时间并执行所有到期的定时器
+     */
+    void advance(uint64_t now_ms) {
+        if (now_ms < _now_ms) return;
+        _now_ms = now_ms;
+        uint64_t target = now_ms / _tick_ms;
+        if (_count == 0) {
+            _tick = target + 1;
+            return;
+        }
+        while (_tick <= target) {
+            uint64_t tick = _tick;
+            if ((tick & kRootMask) == 0) {
+                // 第0层转完一圈，从高层依次级联
+                for (int level = 0; level < kLevels; ++level) {
+                    size_t idx = (tick >> (kRootBits + level * kLevelBits)) & kLevelMask;
+                    cascade(_levels[level][idx]);
+                    if (idx != 0) break;
+                }
+            }
+
+            std::vector<Timer::Ptr> expired;
+            expired.swap(_root[tick & kRootMask]);
+            _count -= expired.size();
+            _root_count -= expired.size();
+            _tick = tick + 1;
+
+            for (auto& timer : expired) {
+                if (timer->_cancelled) {
+                    timer->_task = nullptr;
+                    continue;
+                }
+                uint64_t next = timer->_task();
+                if (next && !timer->_cancelled) {
+                    add(timer, next);
+                } else {
+                    timer->_task = nullptr;
+                }
+            }
+            if (_count == 0) {
+                _tick = target + 1;
+                return;
+            }
+        }
+    }
+
+    /**
+     * 距离下一次需要advance的毫秒数，用作epoll_wait超时
+     * @return 没有定时器时返回-1
+     */
+    int nextTimeout(uint64_t now_ms) const {
+        if (_count == 0) return -1;
+
+        // 高层还有定时器时，最晚要在下一个第0层边界（可能就是当前tick）醒来级联
+        uint64_t limit = _count > _root_count ? (kRootSize - (_tick & kRootMask)) & kRootMask : kRootSize;
+        uint64_t ticks = limit;
+        if (_root_count > 0) {
+            for (uint64_t i = 0; i < limit; ++i) {
+                if (!_root[(_tick + i) & kRootMask].empty()) {
+                    ticks = i;
+                    break;
+                }
+            }
+        }
+        uint64_t wake_ms = (_tick + ticks) * _tick_ms;
+        return wake_ms > now_ms ? (int)(wake_ms - now_ms) : 0;
+    }
+
+    size_t size() const { return _count; }
+
+private:
+    static constexpr int kRootBits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr int kLevels = 3;
+    static constexpr uint64_t kRootSize = 1ULL << kRootBits;
+    static constexpr uint64_t kRootMask = kRootSize - 1;
+    static constexpr uint64_t kLevelSize = 1ULL << kLevelBits;
+    static constexpr uint64_t kLevelMask = kLevelSize - 1;
+    static constexpr uint64_t kMaxDelta = 1ULL << (kRootBits + kLevels * kLevelBits);
+
+    void link(const Timer::Ptr& timer) {
+        uint64_t expire = timer->_expire_tick;
+        if (expire < _tick) expire = _tick;
+        uint64_t delta = expire - _tick;
+        if (delta >= kMaxDelta) {
+            // 超出时间轮范围，放在最远处，到期时会重新计算
+            delta = kMaxDelta - 1;
+            expire = _tick + delta;
+        }
+
+        ++_count;
+        if (delta < kRootSize) {
+            _root[expire & kRootMask].push_back(timer);
+            ++_root_count;
+            return;
+        }
+        for (int level = 0; level < kLevels; ++level) {
+            int shift = kRootBits + level * kLevelBits;
+            if (delta < (1ULL << (shift + kLevelBits))) {
+                _levels[level][(expire >> shift) & kLevelMask].push_back(timer);
+                return;
+            }
+        }
+    }
+
+    void cascade(std::vector<Timer::Ptr>& slot) {
+        std::vector<Timer::Ptr> timers;
+        timers.swap(slot);
+        _count -= timers.size();
+        for (auto& timer : timers) {
+            if (timer->_cancelled) {
+                timer->_task = nullptr;
+                continue;
+            }
+            link(timer);
+        }
+    }
+
+private:
+    uint64_t _tick_ms;
+    uint64_t _now_ms;
+    uint64_t _tick;
+    size_t _count = 0;
+    size_t _root_count = 0;
+    std::vector<Timer::Ptr> _root[kRootSize];
+    std::vector<Timer::Ptr> _levels[kLevels][kLevelSize];
+};
+
+} // namespace toolkit
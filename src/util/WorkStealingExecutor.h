@@ -0,0 +1,309 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <pthread.h>
+#include "util/ThreadPlacement.h"
+
+namespace toolkit {
+
+/**
+ * 工作窃取线程池，用于把消费者回调从I/O线程上移走
+ * 每个worker有自己的任务队列，本地从队头取，空闲时从其他worker队尾窃取
+ * 需要保序的任务通过Strand投递：同一Strand的任务串行执行，并优先回到上次执行它的worker（缓存亲和）
+ * 绑核与NUMA配置复用EventPollerPool的CpuSet/ThreadPlacement
+ */
+class WorkStealingExecutor {
+public:
+    using Task = std::function<void()>;
+
+    struct Config {
+        // worker数量，0表示CPU核数（配置了cpus时取cpus.size()）
+        size_t size = 0;
+        // 每个worker绑定的CPU集合，按下标分配，不足时循环使用
+        std::vector<CpuSet> cpus;
+        bool numa_local = false;
+        // Strand每次调度最多连续执行的任务数，超过后让出worker，避免单路流饿死其他流
+        size_t strand_batch = 64;
+    };
+
+    struct WorkerStats {
+        size_t depth = 0;        // 当前队列深度
+        size_t max_depth = 0;    // 历史最大队列深度
+        uint64_t executed = 0;   // 已执行任务数
+        uint64_t stolen = 0;     // 从其他worker窃取的任务数
+    };
+
+    /**
+     * 串行执行队列，同一个Strand的任务按投递顺序执行，不会并发
+     */
+    class Strand : public std::enable_shared_from_this<Strand> {
+    public:
+        using Ptr = std::shared_ptr<Strand>;
+
+        Strand(WorkStealingExecutor& executor, int home) : _executor(executor), _home(home) {}
+
+        /**
+         * 投递任务，可在任意线程调用
+         * @return 超过setMaxPending限制被丢弃时返回false
+         */
+        bool post(Task task) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_max_pending && _queue.size() >= _max_pending) {
+                    ++_dropped;
+                    return false;
+                }
+                _queue.emplace_back(std::move(task));
+                _pending = _queue.size();
+                if (_queue.size() > _max_depth) _max_depth = _queue.size();
+                if (_scheduled) return true;
+                _scheduled = true;
+            }
+            schedule();
+            return true;
+        }
+
+        /**
+         * 排队任务上限，0表示不限制；消费者持续跟不上时丢弃新任务而不是无限堆积
+         */
+        void setMaxPending(size_t max_pending) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _max_pending = max_pending;
+        }
+
+        size_t pending() const { return _pending; }
+        size_t maxPending() const { return _max_depth; }
+        uint64_t dropped() const { return _dropped; }
+        uint64_t executed() const { return _executed; }
+        int home() const { return _home; }
+
+    private:
+        friend class WorkStealingExecutor;
+
+        void schedule() {
+            auto self = shared_from_this();
+            _executor.post([self]() { self->run(); }, _home);
+        }
+
+        void run() {
+            // 被窃取后亲和性跟随实际执行的worker，下一批仍在该worker上执行
+            int current = WorkStealingExecutor::currentWorker();
+            if (current >= 0) _home = current;
+
+            for (size_t i = 0; i < _executor._config.strand_batch; ++i) {
+                Task task;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_queue.empty()) {
+                        _scheduled = false;
+                        return;
+                    }
+                    task = std::move(_queue.front());
+                    _queue.pop_front();
+                    _pending = _queue.size();
+                }
+                task();
+                ++_executed;
+            }
+            // 本批执行完仍有任务，排到worker队尾，让其他流有机会执行
+            schedule();
+        }
+
+    private:
+        WorkStealingExecutor& _executor;
+        std::atomic<int> _home;
+        std::mutex _mutex;
+        std::deque<Task> _queue;
+        bool _scheduled = false;
+        size_t _max_pending = 0;
+        std::atomic<size_t> _pending{0};
+        std::atomic<size_t> _max_depth{0};
+        std::atomic<uint64_t> _dropped{0};
+        std::atomic<uint64_t> _executed{0};
+    };
+
+    /**
+     * 设置线程池配置，必须在第一次调用Instance()之前设置
+     */
+    static void setConfig(const Config& config) {
+        configRef() = config;
+    }
+
+    static WorkStealingExecutor& Instance() {
+        static WorkStealingExecutor instance(configRef());
+        return instance;
+    }
+
+    /**
+     * 创建Strand，初始worker按轮询分配，使不同流分散在不同核上
+     */
+    Strand::Ptr createStrand() {
+        int home = (int)(_next_home.fetch_add(1, std::memory_order_relaxed) % _workers.size());
+        return std::make_shared<Strand>(*this, home);
+    }
+
+    /**
+     * 投递无需保序的任务
+     * @param worker 目标worker，-1表示当前worker（非worker线程时轮询）
+     */
+    void post(Task task, int worker = -1) {
+        if (worker < 0 || worker >= (int)_workers.size()) {
+            worker = currentWorker();
+            if (worker < 0) worker = (int)(_next_post.fetch_add(1, std::memory_order_relaxed) % _workers.size());
+        }
+        auto& w = *_workers[worker];
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.queue.emplace_back(std::move(task));
+            size_t depth = w.queue.size();
+            w.depth = depth;
+            if (depth > w.max_depth) w.max_depth = depth;
+        }
+        _pending.fetch_add(1);
+        if (_idle.load() > 0) {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _sleep_cond.notify_one();
+        }
+    }
+
+    std::vector<WorkerStats> getStats() const {
+        std::vector<WorkerStats> ret;
+        for (auto& w : _workers) {
+            WorkerStats stats;
+            stats.depth = w->depth;
+            stats.max_depth = w->max_depth;
+            stats.executed = w->executed;
+            stats.stolen = w->stolen;
+            ret.push_back(stats);
+        }
+        return ret;
+    }
+
+    size_t size() const { return _workers.size(); }
+
+    /**
+     * 当前线程所属worker下标，非worker线程返回-1
+     */
+    static int currentWorker() { return currentWorkerRef(); }
+
+    ~WorkStealingExecutor() {
+        _running = false;
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _sleep_cond.notify_all();
+        }
+        for (auto& w : _workers) {
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queue;
+        std::thread thread;
+        std::atomic<size_t> depth{0};
+        std::atomic<size_t> max_depth{0};
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    explicit WorkStealingExecutor(const Config& config) : _config(config) {
+        if (_config.strand_batch == 0) _config.strand_batch = 1;
+        size_t size = config.size;
+        if (size == 0) {
+            size = !config.cpus.empty() ? config.cpus.size() : std::thread::hardware_concurrency();
+        }
+        if (size == 0) size = 1;
+
+        for (size_t i = 0; i < size; ++i) {
+            _workers.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < size; ++i) {
+            CpuSet cpus = config.cpus.empty() ? CpuSet() : config.cpus[i % config.cpus.size()];
+            _workers[i]->thread = std::thread([this, i, cpus]() {
+                pthread_setname_np(pthread_self(), ("worker-" + std::to_string(i)).substr(0, 15).c_str());
+                ThreadPlacement::apply(cpus, _config.numa_local);
+                currentWorkerRef() = (int)i;
+                runWorker(i);
+            });
+        }
+    }
+
+    static Config& configRef() {
+        static Config config;
+        return config;
+    }
+
+    static int& currentWorkerRef() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    bool popLocal(size_t index, Task& task) {
+        auto& w = *_workers[index];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.queue.empty()) return false;
+        task = std::move(w.queue.front());
+        w.queue.pop_front();
+        w.depth = w.queue.size();
+        return true;
+    }
+
+    // 从其他worker队尾窃取，队尾是最晚投递、缓存最冷的任务
+    bool steal(size_t index, Task& task) {
+        size_t n = _workers.size();
+        for (size_t i = 1; i < n; ++i) {
+            auto& victim = *_workers[(index + i) % n];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.queue.empty()) continue;
+            task = std::move(victim.queue.back());
+            victim.queue.pop_back();
+            victim.depth = victim.queue.size();
+            ++_workers[index]->stolen;
+            return true;
+        }
+        return false;
+    }
+
+    void runWorker(size_t index) {
+        auto& self = *_workers[index];
+        while (_running) {
+            Task task;
+            if (popLocal(index, task) || steal(index, task)) {
+                _pending.fetch_sub(1);
+                task();
+                ++self.executed;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_sleep_mutex);
+            _idle.fetch_add(1);
+            if (_pending.load() == 0 && _running) {
+                _sleep_cond.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            _idle.fetch_sub(1);
+        }
+    }
+
+private:
+    Config _config;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<bool> _running{true};
+    std::atomic<size_t> _next_home{0};
+    std::atomic<size_t> _next_post{0};
+    std::atomic<size_t> _pending{0};
+    std::atomic<size_t> _idle{0};
+    std::mutex _sleep_mutex;
+    std::condition_variable _sleep_cond;
+};
+
+} // namespace toolkit
@@ -0,0 +1,310 @@
+/**
+ * ShmRing自检：写者和读者在不同进程（fork），检查顺序读取与futex等待、读者被套圈、关键帧索引槽位复用、
+ * 写者退出时唤醒读者，以及ShmRingExport导出的AVCC帧
+ * 子进程在父进程创建任何线程之前fork，只使用共享内存和管道
+ * 由ctest运行，失败时返回非0
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "util/ShmRing.h"
+#include "rtsp/ShmRingExport.h"
+
+using namespace toolkit;
+
+static int g_failed = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++g_failed;                                                     \
+        }                                                                   \
+    } while (0)
+
+// 进程间的单向通知
+class Signal {
+public:
+    Signal() { CHECK(pipe(_fd) == 0); }
+    ~Signal() {
+        ::close(_fd[0]);
+        ::close(_fd[1]);
+    }
+    void post() {
+        char c = 0;
+        CHECK(::write(_fd[1], &c, 1) == 1);
+    }
+    void wait() {
+        char c;
+        CHECK(::read(_fd[0], &c, 1) == 1);
+    }
+
+private:
+    int _fd[2];
+};
+
+// 在子进程中运行fn，子进程的CHECK失败体现为非0退出码
+template <typename Fn>
+static pid_t spawn(Fn&& fn) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        g_failed = 0;
+        fn();
+        fflush(stdout);
+        fflush(stderr);
+        _exit(g_failed ? 1 : 0);
+    }
+    CHECK(pid > 0);
+    return pid;
+}
+
+static bool join(pid_t pid) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// 记录内容由序号决定，读者据此检查数据未被覆盖或错位
+static std::string payload(uint64_t seq, size_t size) {
+    return std::string(size, (char)('a' + seq % 26));
+}
+
+static bool write(ShmRingWriter& writer, uint64_t seq, bool key, size_t size = 1000) {
+    std::string data = payload(seq, size);
+    return writer.write((uint32_t)(seq * 3600), key, (int64_t)seq * 1000, {{data.data(), data.size()}});
+}
+
+static bool checkRecord(const ShmRingReader& reader, const ShmRingReader::Record& rec, size_t size = 1000) {
+    bool ok = rec.size == size && std::string(rec.data, rec.size) == payload(rec.seq, size) &&
+              rec.timestamp == (uint32_t)(rec.seq * 3600) && rec.wall_us == (int64_t)rec.seq * 1000;
+    return reader.valid(rec) && ok;
+}
+
+static std::string shmName(const char* tag) {
+    return std::string("/shm_ring_check.") + tag + "." + std::to_string(getpid());
+}
+
+// 1. 读者按名字打开，追上写者后在futex上等待，逐条读到所有记录
+static void checkStream() {
+    const uint64_t kCount = 500;
+    ShmRingWriter writer;
+    CHECK(writer.create(shmName("stream"), 1 << 20));
+    writer.setMeta("v=0\r\ns=shm_ring_check\r\n");
+    std::string name = writer.name();
+    Signal opened;
+
+    pid_t pid = spawn([&]() {
+        ShmRingReader reader;
+        CHECK(reader.open(name));
+        opened.post();
+        CHECK(reader.meta() == "v=0\r\ns=shm_ring_check\r\n");
+        CHECK(reader.writerPid() == getppid());
+        ShmRingReader::Record rec;
+        uint64_t expect = 0;
+        int waits = 0;
+        while (expect < kCount) {
+            if (!reader.next(rec)) {
+                ++waits;
+                if (!reader.wait(5000)) break;
+                continue;
+            }
+            CHECK(rec.seq == expect);
+            CHECK(checkRecord(reader, rec));
+            CHECK(rec.key == (rec.seq % 50 == 0));
+            expect = rec.seq + 1;
+        }
+        CHECK(expect == kCount);
+        CHECK(reader.lapped() == 0);
+        // 写者每批之间停顿，读者应多次进入等待
+        CHECK(waits > 10);
+        printf("stream: read %llu records, %d waits\n", (unsigned long long)expect, waits);
+    });
+
+    opened.wait();
+    for (uint64_t seq = 0; seq < kCount; ++seq) {
+        CHECK(write(writer, seq, seq % 50 == 0));
+        if (seq % 10 == 9) {
+            writer.notify();
+            usleep(1000);
+        }
+    }
+    CHECK(join(pid));
+}
+
+// 2. 读者停住时写者写过几圈：读者跳到最旧的关键帧继续，索引槽位复用后定位仍正确
+static void checkLapped() {
+    ShmRingWriter writer;
+    // memfd，读者通过继承的fd映射
+    CHECK(writer.create("", 64 * 1024, 4));
+    uint64_t seq = 0;
+    for (; seq < 20; ++seq) CHECK(write(writer, seq, seq % 5 == 0));
+    Signal paused, written;
+
+    pid_t pid = spawn([&]() {
+        ShmRingReader reader;
+        CHECK(reader.attach(writer.fd()));
+        CHECK(reader.seekOldest());
+        ShmRingReader::Record rec;
+        CHECK(reader.next(rec) && rec.seq == 0);
+        paused.post();
+        written.wait();
+
+        // 索引只有4项，最旧的有效关键帧在索引最后4项之中
+        CHECK(reader.next(rec));
+        CHECK(reader.lapped() == 1);
+        CHECK(rec.key);
+        CHECK(checkRecord(reader, rec));
+        uint64_t first = rec.seq;
+        uint64_t last = first;
+        while (reader.next(rec)) {
+            CHECK(rec.seq == last + 1);
+            CHECK(checkRecord(reader, rec));
+            last = rec.seq;
+        }
+        CHECK(last == 319);
+        CHECK(first >= 300 && first % 5 == 0);
+
+        CHECK(reader.seekLatest() && reader.next(rec));
+        CHECK(rec.seq == 315);
+        // 不晚于该时刻的最后一个关键帧
+        CHECK(reader.seekTime(312 * 1000) && reader.next(rec));
+        CHECK(rec.seq == 310);
+        // 早于所有有效关键帧时定位到最旧的
+        CHECK(reader.seekTime(0) && reader.next(rec));
+        CHECK(rec.seq == first);
+        printf("lapped: resumed at %llu after %llu lap(s)\n", (unsigned long long)first,
+               (unsigned long long)reader.lapped());
+    });
+
+    paused.wait();
+    // 约300KB，数据区64KB，写过4圈多
+    for (; seq < 320; ++seq) CHECK(write(writer, seq, seq % 5 == 0));
+    writer.notify();
+    written.post();
+    CHECK(join(pid));
+}
+
+// 3. 写者退出时唤醒在等待的读者，读者读完剩余数据
+static void checkClose() {
+    ShmRingWriter writer;
+    CHECK(writer.create(shmName("close"), 1 << 16));
+    std::string name = writer.name();
+    Signal opened;
+
+    pid_t pid = spawn([&]() {
+        ShmRingReader reader;
+        CHECK(reader.open(name));
+        opened.post();
+        ShmRingReader::Record rec;
+        // 先收到一条数据，再在写者退出时被唤醒，读完最后一条后不再等待
+        CHECK(reader.wait(5000) && reader.next(rec) && rec.seq == 0);
+        CHECK(reader.wait(5000));
+        CHECK(reader.closed());
+        CHECK(reader.next(rec) && rec.seq == 1);
+        CHECK(!reader.next(rec));
+        CHECK(!reader.wait(5000));
+    });
+
+    opened.wait();
+    usleep(50000);
+    CHECK(write(writer, 0, true));
+    writer.notify();
+    usleep(50000);
+    CHECK(write(writer, 1, false));
+    writer.close();
+    CHECK(join(pid));
+    // 名字已删除
+    ShmRingReader reader;
+    CHECK(!reader.open(name));
+}
+
+static RtpPacket::Ptr packet(uint16_t seq, uint32_t timestamp, bool marker, const std::string& payload) {
+    auto pkt = std::make_shared<RtpPacket>();
+    pkt->pt = 96;
+    pkt->seq = seq;
+    pkt->timestamp = timestamp;
+    pkt->marker = marker;
+    pkt->payload = payload;
+    return pkt;
+}
+
+// 4. ShmRingExport把RingBuffer中的RTP解包为AVCC帧，关键帧前带SPS/PPS
+static void checkExport() {
+    const std::string sps("\x67\x42\x00\x1f", 4);
+    const std::string pps("\x68\xce\x3c\x80", 4);
+    auto exporter = std::make_shared<ShmRingExport>();
+    CHECK(exporter->open("", 1 << 20, 16));
+    Signal opened;
+
+    pid_t pid = spawn([&]() {
+        ShmRingReader reader;
+        CHECK(reader.attach(exporter->fd()));
+        opened.post();
+        std::vector<std::string> frames;
+        std::vector<bool> keys;
+        ShmRingReader::Record rec;
+        while (frames.size() < 3) {
+            if (reader.next(rec)) {
+                frames.emplace_back(rec.data, rec.size);
+                keys.push_back(rec.key);
+                CHECK(reader.valid(rec));
+            } else if (!reader.wait(5000)) {
+                break;
+            }
+        }
+        CHECK(frames.size() == 3);
+        if (frames.size() != 3) return;
+        // [len][SPS][len][PPS][len][IDR]
+        std::string len4("\x00\x00\x00\x04", 4);
+        CHECK(keys[0] && !keys[1] && !keys[2]);
+        CHECK(frames[0].compare(0, 16, len4 + sps + len4 + pps) == 0);
+        CHECK(frames[0].size() == 16 + 4 + 3000);
+        CHECK((uint8_t)frames[0][20] == 0x65);
+        CHECK(frames[1].size() == 4 + 1000 && (uint8_t)frames[1][4] == 0x41);
+    });
+
+    opened.wait();
+    auto client = std::make_shared<RtspClient>();
+    exporter->start(client);
+    // 带内SPS/PPS，IDR分成3个FU-A
+    std::vector<RtpPacket::Ptr> batch;
+    uint16_t seq = 0;
+    batch.push_back(packet(seq++, 0, false, sps));
+    batch.push_back(packet(seq++, 0, false, pps));
+    for (int i = 0; i < 3; ++i) {
+        std::string fu("\x7c", 1);
+        fu.push_back((char)((i == 0 ? 0x80 : 0) | (i == 2 ? 0x40 : 0) | 5));
+        if (i == 0) fu.append(999, 'k');
+        else fu.append(1000, 'k');
+        batch.push_back(packet(seq++, 0, i == 2, fu));
+    }
+    for (uint32_t ts = 3600; ts <= 3 * 3600; ts += 3600) {
+        batch.push_back(packet(seq++, ts, true, "\x41" + std::string(999, 'p')));
+    }
+    auto is_key = [](const RtpPacket::Ptr& pkt) { return pkt->isKeyFrameStart(); };
+    auto frame_of = [](const RtpPacket::Ptr& pkt) { return pkt->timestamp; };
+    // 分两批写入，每批唤醒一次读者
+    client->getRing()->writeBatch(batch.data(), 5, is_key, frame_of);
+    client->getRing()->writeBatch(batch.data() + 5, batch.size() - 5, is_key, frame_of);
+    CHECK(join(pid));
+    client->stop();
+}
+
+int main() {
+    Logger::setLevel(LWarn);
+    checkStream();
+    checkLapped();
+    checkClose();
+    checkExport();
+
+    if (g_failed) {
+        fprintf(stderr, "shm_ring_check: %d check(s) failed\n", g_failed);
+        return 1;
+    }
+    printf("shm_ring_check: ok\n");
+    return 0;
+}
@@ -0,0 +1,545 @@
+/**
+ * 故障注入浸泡测试
+ * 本进程内启动一个模拟摄像头（RTSP over TCP，合成H.264），用RtspClient拉多路流，
+ * 在客户端收包路径注入分片/停顿/复位/丢失，服务端可模拟超大SDP、不回复请求和慢回复，
+ * 消费端可模拟卡顿的异步读者；按固定间隔统计吞吐、端到端延时分位数、RSS和内存分配次数，
+ * 预热结束后与基线比较，超过阈值即以非0退出
+ *
+ * 构建: cmake -DBUILD_SOAK_TEST=ON ..
+ * 示例: ./soak_test --duration 14400 --streams 8 --chunk 1-64 --stall-prob 0.001 --reset-prob 0.0001
+ */
+#include "rtsp/RtspClient.h"
+#include "network/TcpServer.h"
+#include "util/LatencyHistogram.h"
+#include <getopt.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <thread>
+
+// 全局分配计数：替换operator new/delete，统计总分配次数和存活对象数
+static std::atomic<uint64_t> g_alloc_count{0};
+static std::atomic<uint64_t> g_free_count{0};
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    g_free_count.fetch_add(1, std::memory_order_relaxed);
+    free(ptr);
+}
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+static int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static size_t currentRss() {
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp) return 0;
+    unsigned long size = 0, resident = 0;
+    int n = fscanf(fp, "%lu %lu", &size, &resident);
+    fclose(fp);
+    return n == 2 ? resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+/**
+ * 模拟摄像头
+ * 每个负载包的FU头之后写入发送时刻（steady clock，us），客户端据此计算端到端延时
+ */
+class SoakServer {
+public:
+    struct Config {
+        int fps = 25;
+        int gop = 25;
+        size_t frame_bytes = 8000;
+        // 关键帧大小为普通帧的倍数
+        int key_scale = 4;
+        // SDP填充到的字节数，0表示不填充
+        size_t sdp_bytes = 0;
+        // 每个请求不回复的概率，客户端请求超时后重连
+        double no_answer_prob = 0;
+        // 回复延时(ms)
+        uint32_t reply_delay_ms = 0;
+        // 单个会话发送队列上限，超过时丢帧（与真实摄像头行为一致）
+        size_t max_queue_bytes = 4 * 1024 * 1024;
+        uint64_t seed = 0;
+    };
+
+    std::atomic<uint64_t> sent_bytes{0};
+    std::atomic<uint64_t> dropped_frames{0};
+    std::atomic<uint64_t> unanswered{0};
+
+    explicit SoakServer(const Config& config)
+        : _config(config), _rng(config.seed ? config.seed : std::random_device()()) {}
+
+    bool start(uint16_t port) {
+        _server = std::make_shared<TcpServer>();
+        if (!_server->start(port, [this](const EventPoller::Ptr& poller, int fd) {
+                return std::make_shared<Session>(poller, fd, *this);
+            }, "127.0.0.1")) {
+            return false;
+        }
+        _frame_timer = _server->getPoller()->doDelayTask(1000 / _config.fps, [this]() -> uint64_t {
+            sendFrame();
+            return 1000 / _config.fps;
+        });
+        return true;
+    }
+
+    void stop() {
+        if (!_server) return;
+        _frame_timer->cancel();
+        _server->getPoller()->sync([this]() { _playing.clear(); });
+        _server->stop();
+        _server->getPoller()->sync([]() {});
+        _server = nullptr;
+    }
+
+    uint16_t getPort() const { return _server ? _server->getPort() : 0; }
+
+private:
+    class Session : public TcpSession {
+    public:
+        Session(const EventPoller::Ptr& poller, int fd, SoakServer& server) : TcpSession(poller, fd), _server(server) {}
+
+    protected:
+        void onRecv(const Buffer::Ptr& buf) override {
+            _buffer.append(buf->data(), buf->size());
+            size_t end;
+            while ((end = _buffer.find("\r\n\r\n")) != std::string::npos) {
+                std::string req = _buffer.substr(0, end);
+                _buffer.erase(0, end + 4);
+                onRequest(req);
+            }
+        }
+
+    private:
+        void onRequest(const std::string& req) {
+            std::string method = req.substr(0, req.find(' '));
+            std::string cseq;
+            size_t pos = req.find("CSeq:");
+            if (pos != std::string::npos) {
+                size_t start = req.find_first_not_of(' ', pos + 5);
+                cseq = req.substr(start, req.find("\r\n", start) - start);
+            }
+            if (_server.chance(_server._config.no_answer_prob)) {
+                ++_server.unanswered;
+                return;
+            }
+
+            std::string extra, body;
+            if (method == "OPTIONS") {
+                extra = "Public: OPTIONS, DESCRIBE, SETUP, PLAY, GET_PARAMETER, TEARDOWN\r\n";
+            } else if (method == "DESCRIBE") {
+                body = _server.makeSdp();
+                extra = "Content-Type: application/sdp\r\nContent-Base: rtsp://127.0.0.1/live/\r\n";
+            } else if (method == "SETUP") {
+                extra = "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n";
+            }
+            if (method == "SETUP" || method == "PLAY" || method == "GET_PARAMETER") {
+                extra += "Session: 5041;timeout=60\r\n";
+            }
+            std::string resp = "RTSP/1.0 200 OK\r\nCSeq: " + cseq + "\r\n" + extra +
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            bool play = method == "PLAY";
+
+            uint32_t delay = _server._config.reply_delay_ms;
+            if (!delay) {
+                reply(resp, play);
+                return;
+            }
+            std::weak_ptr<TcpSession> weak_self = shared_from_this();
+            getPoller()->doDelayTask(delay, [weak_self, resp, play]() -> uint64_t {
+                if (auto strong_self = std::static_pointer_cast<Session>(weak_self.lock())) {
+                    strong_self->reply(resp, play);
+                }
+                return 0;
+            });
+        }
+
+        void reply(const std::string& resp, bool play) {
+            if (!alive()) return;
+            send(resp);
+            if (play) _server._playing.emplace_back(std::static_pointer_cast<Session>(shared_from_this()));
+        }
+
+    private:
+        SoakServer& _server;
+        std::string _buffer;
+    };
+
+    bool chance(double prob) {
+        return prob > 0 && std::uniform_real_distribution<double>(0, 1)(_rng) < prob;
+    }
+
+    std::string makeSdp() const {
+        std::string sdp = "v=0\r\no=- 0 0 IN IP4 127.0.0.1\r\ns=soak\r\nt=0 0\r\n"
+                          "m=video 0 RTP/AVP 96\r\na=rtpmap:96 H264/90000\r\n"
+                          "a=fmtp:96 packetization-mode=1\r\n";
+        // 超大SDP：填充属性行放在control之前，拆包和解析都要跨越整段填充
+        std::string line = "a=x-soak-pad:" + std::string(96, 'x') + "\r\n";
+        while (sdp.size() + line.size() < _config.sdp_bytes) sdp += line;
+        sdp += "a=control:trackID=0\r\n";
+        return sdp;
+    }
+
+    // 在server loop上每帧调用一次，整帧打包一次，所有会话共享同一个Buffer
+    void sendFrame() {
+        bool key = _frame_index++ % _config.gop == 0;
+        size_t size = _config.frame_bytes * (key ? _config.key_scale : 1);
+        uint8_t nal = key ? 0x65 : 0x41;
+        int64_t now = steadyUs();
+
+        auto frame = std::make_shared<BufferString>();
+        auto& out = frame->ref();
+        out.reserve(size + size / kMaxPayload * 20 + 64);
+        for (size_t pos = 0; pos < size; pos += kMaxPayload) {
+            size_t len = std::min(kMaxPayload, size - pos);
+            bool first = pos == 0, last = pos + len >= size;
+            size_t rtp_len = 12 + 2 + len;
+            uint8_t head[4 + 12 + 2] = {'$', 0, (uint8_t)(rtp_len >> 8), (uint8_t)rtp_len,
+                                         0x80, (uint8_t)((last ? 0x80 : 0) | 96),
+                                         (uint8_t)(_seq >> 8), (uint8_t)_seq,
+                                         (uint8_t)(_timestamp >> 24), (uint8_t)(_timestamp >> 16),
+                                         (uint8_t)(_timestamp >> 8), (uint8_t)_timestamp,
+                                         0, 0, 0x50, 0x41,
+                                         (uint8_t)((nal & 0xE0) | 28),
+                                         (uint8_t)((nal & 0x1F) | (first ? 0x80 : 0) | (last ? 0x40 : 0))};
+            ++_seq;
+            out.append((const char*)head, sizeof(head));
+            size_t at = out.size();
+            out.append(len, (char)0xAB);
+            if (len >= sizeof(now)) memcpy(&out[at], &now, sizeof(now));
+        }
+        _timestamp += 90000 / _config.fps;
+
+        for (size_t i = 0; i < _playing.size();) {
+            auto session = _playing[i].lock();
+            if (!session || !session->alive()) {
+                _playing[i] = std::move(_playing.back());
+                _playing.pop_back();
+                continue;
+            }
+            if (session->sendQueueBytes() > _config.max_queue_bytes) {
+                ++dropped_frames;
+            } else {
+                session->send(frame);
+                sent_bytes += size;
+            }
+            ++i;
+        }
+    }
+
+private:
+    static constexpr size_t kMaxPayload = 1400;
+
+    Config _config;
+    TcpServer::Ptr _server;
+    EventPoller::DelayTask::Ptr _frame_timer;
+    std::mt19937_64 _rng;
+    // 以下只在server loop线程访问
+    std::vector<std::weak_ptr<Session>> _playing;
+    uint64_t _frame_index = 0;
+    uint16_t _seq = 0;
+    uint32_t _timestamp = 0;
+};
+
+/**
+ * 同步读者：统计收到的负载字节和端到端延时，所有流共用，成员均为原子量
+ */
+class SoakReader : public RingReader<SoakReader, RtpPacket::Ptr> {
+public:
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> packets{0};
+    LatencyHistogram latency;
+
+    void onData(const RtpPacket::Ptr& pkt) {
+        ++packets;
+        bytes += pkt->payload.size() >= 2 ? pkt->payload.size() - 2 : 0;
+        int64_t sent;
+        if (pkt->payload.size() >= 2 + sizeof(sent)) {
+            memcpy(&sent, pkt->payload.data() + 2, sizeof(sent));
+            latency.record(steadyUs() - sent);
+        }
+    }
+};
+
+struct Options {
+    int duration_sec = 3600;
+    int interval_sec = 10;
+    int warmup_sec = 30;
+    int streams = 4;
+    SoakServer::Config server;
+    FaultInjector::Config fault;
+    // 卡顿的异步读者：每stall_every个包睡眠stall_ms，排队上限max_pending
+    uint32_t consumer_stall_ms = 0;
+    uint32_t consumer_stall_every = 100;
+    size_t consumer_max_pending = 10000;
+    // 阈值，0表示不检查
+    double max_rss_growth_mb = 64;
+    double max_live_growth = 200000;
+    double min_throughput = 0.5;
+    double max_p99_ms = 0;
+    int tolerance = 3;
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --duration SEC            total run time (3600)\n"
+            "  --interval SEC            report interval (10)\n"
+            "  --warmup SEC              baseline is taken after warmup (30)\n"
+            "  --streams N               concurrent pulls (4)\n"
+            "  --fps N --gop N --frame-bytes N\n"
+            "  --sdp-bytes N             pad DESCRIBE SDP to N bytes\n"
+            "  --no-answer-prob P        server ignores a request\n"
+            "  --reply-delay-ms MS       server reply delay\n"
+            "  --chunk MIN-MAX           split each read into chunks of MIN..MAX bytes\n"
+            "  --stall-prob P --stall-ms MIN-MAX\n"
+            "  --reset-prob P            RST the connection after a read\n"
+            "  --drop-prob P --drop-max N\n"
+            "  --consumer-stall-ms MS --consumer-stall-every N --consumer-max-pending N\n"
+            "  --seed N\n"
+            "  --max-rss-growth-mb MB    fail when RSS grows beyond baseline (64)\n"
+            "  --max-live-growth N       fail when live allocations grow beyond baseline (200000)\n"
+            "  --min-throughput R        fail when received/sent stays below R (0.5)\n"
+            "  --max-p99-ms MS           fail when latency p99 stays above MS (off)\n"
+            "  --tolerance N             consecutive intervals before throughput/latency fail (3)\n",
+            prog);
+}
+
+static bool parseRange(const char* arg, uint64_t& min, uint64_t& max) {
+    unsigned long long a, b;
+    int n = sscanf(arg, "%llu-%llu", &a, &b);
+    if (n < 1) return false;
+    min = a;
+    max = n == 2 ? b : a;
+    return true;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& opt) {
+    static const struct option kOptions[] = {
+        {"duration", required_argument, nullptr, 'd'},
+        {"interval", required_argument, nullptr, 'i'},
+        {"warmup", required_argument, nullptr, 'w'},
+        {"streams", required_argument, nullptr, 'n'},
+        {"fps", required_argument, nullptr, 1},
+        {"gop", required_argument, nullptr, 2},
+        {"frame-bytes", required_argument, nullptr, 3},
+        {"sdp-bytes", required_argument, nullptr, 4},
+        {"no-answer-prob", required_argument, nullptr, 5},
+        {"reply-delay-ms", required_argument, nullptr, 6},
+        {"chunk", required_argument, nullptr, 7},
+        {"stall-prob", required_argument, nullptr, 8},
+        {"stall-ms", required_argument, nullptr, 9},
+        {"reset-prob", required_argument, nullptr, 10},
+        {"drop-prob", required_argument, nullptr, 11},
+        {"drop-max", required_argument, nullptr, 12},
+        {"consumer-stall-ms", required_argument, nullptr, 13},
+        {"consumer-stall-every", required_argument, nullptr, 14},
+        {"consumer-max-pending", required_argument, nullptr, 15},
+        {"seed", required_argument, nullptr, 16},
+        {"max-rss-growth-mb", required_argument, nullptr, 17},
+        {"max-live-growth", required_argument, nullptr, 18},
+        {"min-throughput", required_argument, nullptr, 19},
+        {"max-p99-ms", required_argument, nullptr, 20},
+        {"tolerance", required_argument, nullptr, 21},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    int c;
+    uint64_t min, max;
+    while ((c = getopt_long(argc, argv, "d:i:w:n:h", kOptions, nullptr)) != -1) {
+        switch (c) {
+            case 'd': opt.duration_sec = atoi(optarg); break;
+            case 'i': opt.interval_sec = std::max(1, atoi(optarg)); break;
+            case 'w': opt.warmup_sec = atoi(optarg); break;
+            case 'n': opt.streams = std::max(1, atoi(optarg)); break;
+            case 1: opt.server.fps = std::max(1, atoi(optarg)); break;
+            case 2: opt.server.gop = std::max(1, atoi(optarg)); break;
+            case 3: opt.server.frame_bytes = strtoul(optarg, nullptr, 10); break;
+            case 4: opt.server.sdp_bytes = strtoul(optarg, nullptr, 10); break;
+            case 5: opt.server.no_answer_prob = atof(optarg); break;
+            case 6: opt.server.reply_delay_ms = (uint32_t)atoi(optarg); break;
+            case 7:
+                if (!parseRange(optarg, min, max)) return false;
+                opt.fault.chunk_min = min;
+                opt.fault.chunk_max = max;
+                break;
+            case 8: opt.fault.stall_prob = atof(optarg); break;
+            case 9:
+                if (!parseRange(optarg, min, max)) return false;
+                opt.fault.stall_min_ms = (uint32_t)min;
+                opt.fault.stall_max_ms = (uint32_t)max;
+                break;
+            case 10: opt.fault.reset_prob = atof(optarg); break;
+            case 11: opt.fault.drop_prob = atof(optarg); break;
+            case 12: opt.fault.drop_max = strtoul(optarg, nullptr, 10); break;
+            case 13: opt.consumer_stall_ms = (uint32_t)atoi(optarg); break;
+            case 14: opt.consumer_stall_every = std::max(1, atoi(optarg)); break;
+            case 15: opt.consumer_max_pending = strtoul(optarg, nullptr, 10); break;
+            case 16:
+                opt.fault.seed = strtoull(optarg, nullptr, 10);
+                opt.server.seed = opt.fault.seed + 1;
+                break;
+            case 17: opt.max_rss_growth_mb = atof(optarg); break;
+            case 18: opt.max_live_growth = atof(optarg); break;
+            case 19: opt.min_throughput = atof(optarg); break;
+            case 20: opt.max_p99_ms = atof(optarg); break;
+            case 21: opt.tolerance = std::max(1, atoi(optarg)); break;
+            default: return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+    // 注入的故障会产生大量重连日志
+    Logger::setLevel(LError);
+
+    auto server = std::make_shared<SoakServer>(opt.server);
+    if (!server->start(0)) {
+        fprintf(stderr, "start server failed\n");
+        return 2;
+    }
+    std::string url = "rtsp://127.0.0.1:" + std::to_string(server->getPort()) + "/live";
+
+    auto injector = std::make_shared<FaultInjector>(opt.fault);
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> slow_packets{0};
+    SoakReader reader;
+
+    struct Stream {
+        RtspClient::Ptr client;
+        RingBuffer<RtpPacket::Ptr>::ReaderId reader_id = 0;
+        RingBuffer<RtpPacket::Ptr>::ReaderId slow_id = 0;
+        WorkStealingExecutor::Strand::Ptr strand;
+    };
+    std::vector<Stream> streams(opt.streams);
+    for (auto& stream : streams) {
+        stream.client = std::make_shared<RtspClient>();
+        stream.client->setTimeout(2000, 3000);
+        stream.client->setReconnect(true, 100, 2000);
+        stream.client->setFaultInjector(injector);
+        stream.client->setOnPlayResult([&failures](bool success, const std::string&) {
+            if (!success) ++failures;
+        });
+        auto ring = stream.client->getRing();
+        stream.reader_id = ring->attach(&reader, false);
+        if (opt.consumer_stall_ms) {
+            stream.strand = WorkStealingExecutor::Instance().createStrand();
+            stream.strand->setMaxPending(opt.consumer_max_pending);
+            uint32_t stall_ms = opt.consumer_stall_ms, every = opt.consumer_stall_every;
+            stream.slow_id = ring->attachAsync([&slow_packets, stall_ms, every](const RtpPacket::Ptr&) {
+                if (++slow_packets % every == 0) std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+            }, stream.strand, false);
+        }
+        stream.client->play(url);
+    }
+
+    printf("soak: %d streams from %s, %ds, report every %ds, warmup %ds\n", opt.streams, url.c_str(),
+           opt.duration_sec, opt.interval_sec, opt.warmup_sec);
+
+    size_t base_rss = 0;
+    int64_t base_live = 0;
+    bool have_base = false;
+    int low_throughput = 0, high_latency = 0;
+    std::string fail;
+
+    uint64_t last_rx = 0, last_tx = 0, last_alloc = 0;
+    int64_t start_us = steadyUs();
+    for (int elapsed = opt.interval_sec; elapsed <= opt.duration_sec && fail.empty(); elapsed += opt.interval_sec) {
+        int64_t wake = start_us + (int64_t)elapsed * 1000000;
+        std::this_thread::sleep_for(std::chrono::microseconds(std::max<int64_t>(wake - steadyUs(), 0)));
+
+        uint64_t rx = reader.bytes, tx = server->sent_bytes, alloc = g_alloc_count;
+        int64_t live = (int64_t)(alloc - g_free_count.load());
+        size_t rss = currentRss();
+        double ratio = tx > last_tx ? (double)(rx - last_rx) / (tx - last_tx) : 0;
+        double mbps = (rx - last_rx) * 8.0 / opt.interval_sec / 1e6;
+        double p99_ms = reader.latency.percentile(99) / 1000.0;
+
+        uint64_t slow_dropped = 0;
+        for (auto& stream : streams) {
+            if (stream.strand) slow_dropped += stream.strand->dropped();
+        }
+        auto& fs = injector->getStats();
+        printf("[%6ds] rx=%.2fMbps ratio=%.3f latency(%s) rss=%.1fMB live=%lld allocs/s=%llu "
+               "fail=%llu chunks=%llu stalls=%llu resets=%llu drops=%llu unanswered=%llu srv_drop=%llu slow_drop=%llu\n",
+               elapsed, mbps, ratio, reader.latency.toString().c_str(), rss / 1048576.0, (long long)live,
+               (unsigned long long)((alloc - last_alloc) / opt.interval_sec), (unsigned long long)failures.load(),
+               (unsigned long long)fs.chunks.load(), (unsigned long long)fs.stalls.load(),
+               (unsigned long long)fs.resets.load(), (unsigned long long)fs.drops.load(),
+               (unsigned long long)server->unanswered.load(), (unsigned long long)server->dropped_frames.load(),
+               (unsigned long long)slow_dropped);
+        fflush(stdout);
+        reader.latency.reset();
+        last_rx = rx;
+        last_tx = tx;
+        last_alloc = alloc;
+
+        if (elapsed < opt.warmup_sec) continue;
+        if (!have_base) {
+            have_base = true;
+            base_rss = rss;
+            base_live = live;
+            continue;
+        }
+
+        char buf[256];
+        if (opt.max_rss_growth_mb > 0 && rss > base_rss && (rss - base_rss) / 1048576.0 > opt.max_rss_growth_mb) {
+            snprintf(buf, sizeof(buf), "rss grew %.1fMB over baseline %.1fMB", (rss - base_rss) / 1048576.0,
+                     base_rss / 1048576.0);
+            fail = buf;
+        } else if (opt.max_live_growth > 0 && live - base_live > opt.max_live_growth) {
+            snprintf(buf, sizeof(buf), "live allocations grew by %lld over baseline %lld",
+                     (long long)(live - base_live), (long long)base_live);
+            fail = buf;
+        }
+        low_throughput = opt.min_throughput > 0 && ratio < opt.min_throughput ? low_throughput + 1 : 0;
+        high_latency = opt.max_p99_ms > 0 && p99_ms > opt.max_p99_ms ? high_latency + 1 : 0;
+        if (fail.empty() && low_throughput >= opt.tolerance) {
+            snprintf(buf, sizeof(buf), "throughput ratio below %.3f for %d intervals", opt.min_throughput,
+                     low_throughput);
+            fail = buf;
+        } else if (fail.empty() && high_latency >= opt.tolerance) {
+            snprintf(buf, sizeof(buf), "latency p99 above %.1fms for %d intervals", opt.max_p99_ms, high_latency);
+            fail = buf;
+        }
+    }
+
+    for (auto& stream : streams) {
+        stream.client->stop();
+        auto ring = stream.client->getRing();
+        ring->detach(stream.reader_id);
+        if (stream.slow_id) ring->detach(stream.slow_id);
+    }
+    server->stop();
+
+    if (!fail.empty()) {
+        printf("soak FAILED: %s\n", fail.c_str());
+        return 1;
+    }
+    printf("soak passed\n");
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * TimeShiftBuffer自检：环形覆盖、RTP时间戳回绕后的定位、多slice关键帧索引、读者被套圈
+ * 由ctest运行，失败时返回非0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "rtsp/TimeShiftBuffer.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++g_failed;                                                     \
+        }                                                                   \
+    } while (0)
+
+// 合成H264流：每帧一个时间戳，关键帧为 SPS + PPS + 多个IDR slice（FU-A），非关键帧为单个FU-A
+class StreamWriter {
+public:
+    StreamWriter(TimeShiftBuffer& buffer, uint32_t timestamp) : _buffer(buffer), _timestamp(timestamp) {}
+
+    void frame(bool key, int slices = 1, size_t slice_bytes = 3000) {
+        if (key) {
+            put(std::string("\x67\x42\x00\x1f", 4), false);
+            put(std::string("\x68\xce\x3c\x80", 4), false);
+        }
+        for (int s = 0; s < slices; ++s) {
+            uint8_t type = key ? 5 : 1;
+            for (size_t off = 0; off < slice_bytes; off += kMtu) {
+                size_t n = std::min(kMtu, slice_bytes - off);
+                bool last = off + n >= slice_bytes;
+                std::string payload;
+                payload.push_back((char)(0x60 | 28));
+                payload.push_back((char)((off == 0 ? 0x80 : 0) | (last ? 0x40 : 0) | type));
+                payload.append(n, (char)_seq);
+                put(payload, last && s == slices - 1);
+            }
+        }
+        _timestamp += 3600;
+        _wall_us += 40000;
+    }
+
+    uint32_t timestamp() const { return _timestamp; }
+    int64_t wallUs() const { return _wall_us; }
+    uint16_t seq() const { return _seq; }
+
+private:
+    void put(const std::string& payload, bool marker) {
+        RtpPacket pkt;
+        pkt.pt = 96;
+        pkt.seq = _seq++;
+        pkt.timestamp = _timestamp;
+        pkt.ssrc = 0x1234;
+        pkt.marker = marker;
+        pkt.payload = payload;
+        _buffer.write(pkt, _wall_us);
+    }
+
+    static constexpr size_t kMtu = 1400;
+    TimeShiftBuffer& _buffer;
+    uint32_t _timestamp;
+    int64_t _wall_us = 1000000000000LL;
+    uint16_t _seq = 0;
+};
+
+static std::string tempPath() {
+    const char* dir = getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/timeshift_check." + std::to_string(getpid());
+}
+
+// 从当前位置顺序读完，检查序号连续、数据未被覆盖
+static size_t readAll(TimeShiftBuffer::Reader& reader, uint16_t& first_seq, bool& first_is_sps) {
+    TimeShiftBuffer::Record rec;
+    size_t count = 0;
+    uint16_t expect = 0;
+    while (reader.next(rec)) {
+        if (count == 0) {
+            first_seq = rec.seq;
+            first_is_sps = rec.size > 0 && (rec.payload[0] & 0x1F) == 7;
+        } else {
+            CHECK(rec.seq == expect);
+        }
+        expect = rec.seq + 1;
+        CHECK(reader.valid(rec));
+        ++count;
+    }
+    return count;
+}
+
+int main() {
+    std::string path = tempPath();
+
+    // 1. 多slice关键帧只索引一次，位置在SPS
+    {
+        auto buffer = std::make_shared<TimeShiftBuffer>(1 << 20, 64);
+        CHECK(buffer->open(path));
+        StreamWriter writer(*buffer, 1000);
+        writer.frame(true, 4);
+        for (int i = 0; i < 5; ++i) writer.frame(false);
+
+        auto reader = buffer->createReader();
+        CHECK(reader.seekLatest());
+        uint16_t first_seq = 0xFFFF;
+        bool first_is_sps = false;
+        readAll(reader, first_seq, first_is_sps);
+        CHECK(first_seq == 0);
+        CHECK(first_is_sps);
+
+        // 第二个关键帧之后最新的关键帧指向它的SPS
+        uint16_t key_seq = writer.seq();
+        writer.frame(true, 4);
+        CHECK(reader.seekLatest());
+        readAll(reader, first_seq, first_is_sps);
+        CHECK(first_seq == key_seq);
+        CHECK(first_is_sps);
+    }
+
+    // 2. 环形覆盖、RTP时间戳回绕、读者被套圈
+    {
+        auto buffer = std::make_shared<TimeShiftBuffer>(1 << 20, 64);
+        CHECK(buffer->open(path));
+        // 约2s后时间戳回绕
+        StreamWriter writer(*buffer, 0xFFFFFFFFu - 3600 * 50);
+        auto lagging = buffer->createReader();
+
+        std::vector<std::pair<uint32_t, uint16_t>> keys;  // 每个关键帧的时间戳和SPS序号
+        for (int i = 0; i < 200; ++i) {
+            bool key = i % 10 == 0;
+            if (key) keys.emplace_back(writer.timestamp(), writer.seq());
+            writer.frame(key, 2);
+            if (i == 5) {
+                CHECK(lagging.seekOldest());
+            }
+        }
+        // 写入约2.4MB，超过一圈
+        CHECK(buffer->size() <= buffer->capacity());
+
+        // 从最旧的关键帧读到最新，全程连续
+        auto reader = buffer->createReader();
+        CHECK(reader.seekOldest());
+        uint16_t first_seq = 0;
+        bool first_is_sps = false;
+        size_t count = readAll(reader, first_seq, first_is_sps);
+        CHECK(count > 0);
+        CHECK(first_is_sps);
+        CHECK((uint16_t)(writer.seq() - first_seq) == count);
+
+        // 回绕前后的时间戳都能定位到对应的关键帧
+        int64_t oldest_us = 0, latest_us = 0;
+        CHECK(buffer->range(oldest_us, latest_us));
+        size_t checked = 0;
+        bool crossed = false;
+        for (size_t i = 1; i < keys.size(); ++i) {
+            if (keys[i].first < keys[i - 1].first) crossed = true;
+            // 已被覆盖的关键帧跳过
+            if ((uint16_t)(keys[i].second - first_seq) >= 0x8000) continue;
+            auto seek = buffer->createReader();
+            TimeShiftBuffer::Record rec;
+            CHECK(seek.seekRtp(keys[i].first + 1800));
+            CHECK(seek.next(rec));
+            CHECK(rec.seq == keys[i].second);
+            CHECK(rec.timestamp == keys[i].first);
+            ++checked;
+        }
+        CHECK(crossed);
+        CHECK(checked >= 3);
+
+        // 早于缓冲起点时定位到最旧的关键帧
+        auto early = buffer->createReader();
+        CHECK(early.seekRtp(keys.front().first));
+        TimeShiftBuffer::Record rec;
+        CHECK(early.next(rec) && rec.seq == first_seq);
+
+        // 停在第5帧的读者已被套圈，跳到最旧的关键帧继续
+        CHECK(lagging.next(rec));
+        CHECK(lagging.lapped() == 1);
+        CHECK(rec.seq == first_seq);
+        CHECK((rec.payload[0] & 0x1F) == 7);
+    }
+
+    unlink(path.c_str());
+    if (g_failed) {
+        fprintf(stderr, "timeshift_check: %d check(s) failed\n", g_failed);
+        return 1;
+    }
+    printf("timeshift_check: ok\n");
+    return 0;
+}
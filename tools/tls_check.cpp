@@ -0,0 +1,290 @@
+/**
+ * RTSPS自检：本地TLS RTSP摄像头替身，检查拉流、重连时的会话恢复（TLS1.2/1.3）和流中途的KeyUpdate
+ * 证书在进程内生成；替身每个连接一个线程，阻塞读写
+ * 环境不支持内核TLS时KeyUpdate由OpenSSL处理，支持时客户端应断开重连，两种情况下都要求断开后仍能继续收流
+ * 另检查SDP中绝对rtsps://控制URL：SETUP必须发到该URL，否则替身回复404
+ * 由ctest运行，失败时返回非0
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <csignal>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/ec.h>
+#include "rtsp/RtspClient.h"
+
+using namespace toolkit;
+
+static int g_failed = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++g_failed;                                                     \
+        }                                                                   \
+    } while (0)
+
+class TlsCamera {
+public:
+    ~TlsCamera() { stop(); }
+
+    bool start(int max_version, int key_update_frame, bool absolute_control = false) {
+        _key_update_frame = key_update_frame;
+        _absolute_control = absolute_control;
+        _ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_set_min_proto_version(_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_max_proto_version(_ctx, max_version);
+        SSL_CTX_set_session_id_context(_ctx, (const unsigned char*)"tls_check", 9);
+        if (!makeCert()) return false;
+
+        _listen_fd = SockUtil::listen(0, "127.0.0.1");
+        if (_listen_fd < 0) return false;
+        SockUtil::setNoBlocked(_listen_fd, false);
+        _port = SockUtil::getLocalPort(_listen_fd);
+        _accept_thread = std::thread([this]() { acceptLoop(); });
+        return true;
+    }
+
+    void stop() {
+        if (_listen_fd < 0) return;
+        _stopped = true;
+        ::shutdown(_listen_fd, SHUT_RDWR);
+        _accept_thread.join();
+        for (auto& thread : _threads) thread.join();
+        _threads.clear();
+        ::close(_listen_fd);
+        _listen_fd = -1;
+        SSL_CTX_free(_ctx);
+    }
+
+    uint16_t port() const { return _port; }
+    int connections() const { return _connections; }
+    int keyUpdates() const { return _key_updates; }
+    int badSetups() const { return _bad_setups; }
+
+private:
+    bool makeCert() {
+        EVP_PKEY* pkey = nullptr;
+        EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        if (!kctx || EVP_PKEY_keygen_init(kctx) != 1 ||
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) != 1 ||
+            EVP_PKEY_keygen(kctx, &pkey) != 1) {
+            EVP_PKEY_CTX_free(kctx);
+            return false;
+        }
+        EVP_PKEY_CTX_free(kctx);
+
+        X509* cert = X509_new();
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, pkey);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        bool ok = X509_sign(cert, pkey, EVP_sha256()) > 0 && SSL_CTX_use_certificate(_ctx, cert) == 1 &&
+                  SSL_CTX_use_PrivateKey(_ctx, pkey) == 1;
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return ok;
+    }
+
+    void acceptLoop() {
+        while (!_stopped) {
+            int fd = ::accept(_listen_fd, nullptr, nullptr);
+            if (fd < 0) return;
+            ++_connections;
+            _threads.emplace_back([this, fd]() { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        SSL* ssl = SSL_new(_ctx);
+        SSL_set_fd(ssl, fd);
+        struct timeval tv{0, 200000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        bool playing = false;
+        if (SSL_accept(ssl) == 1) {
+            std::string buffer;
+            char data[4096];
+            while (!_stopped && !playing) {
+                int n = SSL_read(ssl, data, sizeof(data));
+                if (n <= 0) {
+                    if (SSL_get_error(ssl, n) == SSL_ERROR_WANT_READ || errno == EAGAIN) continue;
+                    break;
+                }
+                buffer.append(data, n);
+                size_t end;
+                while ((end = buffer.find("\r\n\r\n")) != std::string::npos) {
+                    std::string req = buffer.substr(0, end);
+                    buffer.erase(0, end + 4);
+                    std::string resp = answer(req, playing);
+                    SSL_write(ssl, resp.data(), (int)resp.size());
+                }
+            }
+            if (playing) stream(ssl);
+        }
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ::close(fd);
+    }
+
+    std::string answer(const std::string& req, bool& playing) {
+        size_t sp = req.find(' ');
+        std::string method = req.substr(0, sp);
+        std::string url = req.substr(sp + 1, req.find(' ', sp + 1) - sp - 1);
+        std::string track = "rtsps://127.0.0.1:" + std::to_string(_port) + "/media/track1";
+        std::string cseq;
+        size_t pos = req.find("CSeq:");
+        if (pos != std::string::npos) {
+            size_t start = req.find_first_not_of(' ', pos + 5);
+            cseq = req.substr(start, req.find("\r\n", start) - start);
+        }
+        std::string extra, body;
+        if (method == "DESCRIBE") {
+            body = "v=0\r\no=- 0 0 IN IP4 127.0.0.1\r\ns=tls\r\nt=0 0\r\n"
+                   "m=video 0 RTP/AVP 96\r\na=rtpmap:96 H264/90000\r\n"
+                   "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAH5WoFAFuQA==,aM48gA==\r\n"
+                   "a=control:" + (_absolute_control ? track : std::string("trackID=0")) + "\r\n";
+            extra = "Content-Type: application/sdp\r\n";
+        } else if (method == "SETUP") {
+            if (_absolute_control && url != track) {
+                ++_bad_setups;
+                return "RTSP/1.0 404 Not Found\r\nCSeq: " + cseq + "\r\nContent-Length: 0\r\n\r\n";
+            }
+            extra = "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n";
+        }
+        if (method == "SETUP" || method == "PLAY" || method == "GET_PARAMETER") {
+            extra += "Session: 7001;timeout=60\r\n";
+        }
+        playing = playing || method == "PLAY";
+        return "RTSP/1.0 200 OK\r\nCSeq: " + cseq + "\r\n" + extra +
+               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    // 每40ms一帧，每帧一个单NALU包
+    void stream(SSL* ssl) {
+        uint16_t seq = 0;
+        uint32_t timestamp = 0;
+        for (int frame = 0; !_stopped; ++frame) {
+            // 只在第一个连接上触发，重连后正常收流
+            if (frame == _key_update_frame && SSL_version(ssl) == TLS1_3_VERSION && !_key_update_sent.exchange(true)) {
+                if (SSL_key_update(ssl, SSL_KEY_UPDATE_NOT_REQUESTED) == 1) ++_key_updates;
+            }
+            bool key = frame % 25 == 0;
+            std::string payload(1000, 'x');
+            payload[0] = key ? 0x65 : 0x41;
+            size_t rtp_len = 12 + payload.size();
+            std::string out = {'$', 0, (char)(rtp_len >> 8), (char)rtp_len,
+                               (char)0x80, (char)(0x80 | 96), (char)(seq >> 8), (char)seq,
+                               (char)(timestamp >> 24), (char)(timestamp >> 16), (char)(timestamp >> 8), (char)timestamp,
+                               0, 0, 0x12, 0x34};
+            out += payload;
+            if (SSL_write(ssl, out.data(), (int)out.size()) <= 0) return;
+            ++seq;
+            timestamp += 3600;
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        }
+    }
+
+private:
+    SSL_CTX* _ctx = nullptr;
+    int _listen_fd = -1;
+    uint16_t _port = 0;
+    int _key_update_frame = -1;
+    bool _absolute_control = false;
+    std::atomic<int> _bad_setups{0};
+    std::atomic<bool> _stopped{false};
+    std::atomic<int> _connections{0};
+    std::atomic<int> _key_updates{0};
+    std::atomic<bool> _key_update_sent{false};
+    std::thread _accept_thread;
+    std::vector<std::thread> _threads;
+};
+
+struct PlayResult {
+    int packets = 0;
+    bool reused = false;
+    bool kernel_recv = false;
+};
+
+// 拉流直到收到want个包或超时
+static PlayResult play(uint16_t port, int want, int timeout_ms) {
+    PlayResult result;
+    auto client = std::make_shared<RtspClient>();
+    std::atomic<int> packets{0};
+    auto id = client->getRing()->attach([&packets](const RtpPacket::Ptr&) { ++packets; });
+    client->play("rtsps://127.0.0.1:" + std::to_string(port) + "/live");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (packets < want && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    result.packets = packets;
+    result.reused = client->tlsSessionReused();
+    result.kernel_recv = client->tlsKernelRecv();
+    client->getRing()->detach(id);
+    client->stop();
+    return result;
+}
+
+static void checkResumption(int max_version, const char* name) {
+    TlsCamera camera;
+    CHECK(camera.start(max_version, -1));
+    PlayResult first = play(camera.port(), 10, 5000);
+    PlayResult second = play(camera.port(), 10, 5000);
+    printf("%s: first %d packets (resumed %d, ktls %d), second %d packets (resumed %d, ktls %d)\n", name,
+           first.packets, (int)first.reused, (int)first.kernel_recv, second.packets, (int)second.reused,
+           (int)second.kernel_recv);
+    CHECK(first.packets >= 10);
+    CHECK(second.packets >= 10);
+    CHECK(!first.reused);
+    CHECK(second.reused);
+    camera.stop();
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    Logger::setLevel(LWarn);
+    // 每个场景使用新端口，会话缓存按host:port区分
+    checkResumption(TLS1_2_VERSION, "tls1.2");
+    checkResumption(TLS1_3_VERSION, "tls1.3");
+
+    // 第10帧后KeyUpdate：内核TLS下客户端断开后重连，否则OpenSSL直接处理；之后都应继续收流
+    {
+        TlsCamera camera;
+        CHECK(camera.start(TLS1_3_VERSION, 10));
+        PlayResult result = play(camera.port(), 60, 8000);
+        printf("key update: %d packets, %d key update(s), %d connection(s), ktls %d\n", result.packets,
+               camera.keyUpdates(), camera.connections(), (int)result.kernel_recv);
+        CHECK(camera.keyUpdates() >= 1);
+        CHECK(result.packets >= 60);
+        camera.stop();
+    }
+
+    // SDP中的绝对rtsps://控制URL原样用于SETUP，不拼到Content-Base之后
+    {
+        TlsCamera camera;
+        CHECK(camera.start(TLS1_3_VERSION, -1, true));
+        PlayResult result = play(camera.port(), 10, 5000);
+        printf("absolute control: %d packets, %d bad setup(s)\n", result.packets, camera.badSetups());
+        CHECK(result.packets >= 10);
+        CHECK(camera.badSetups() == 0);
+        camera.stop();
+    }
+
+    if (g_failed) {
+        fprintf(stderr, "tls_check: %d check(s) failed\n", g_failed);
+        return 1;
+    }
+    printf("tls_check: ok\n");
+    return 0;
+}